@@ -0,0 +1,39 @@
+#!/bin/bash
+# Search time of efim with the static thresholds and with --adaptive-thresholds, as the minimum of interleaved runs.
+#
+#   $ ./bench/adaptive_thresholds_ab.sh ${run} ${dataset}:${minutil} [${dataset}:${minutil} ...]
+#
+# environment: SCHED (default dphim), THREADS (default nproc), REPEAT (default 5)
+
+set -eu
+
+if [ $# -lt 2 ]; then
+    echo "usage: $0 \${run} \${dataset}:\${minutil} [\${dataset}:\${minutil} ...]" >&2
+    exit 1
+fi
+
+RUN=$1
+shift
+SCHED=${SCHED:-dphim}
+THREADS=${THREADS:-$(nproc)}
+REPEAT=${REPEAT:-5}
+
+search_ms() {
+    "$RUN" -a efim -s "$SCHED" -t "$THREADS" -i "$1" -o /dev/null -m "$2" "${@:3}" | awk '/Search:/ {print $2}'
+}
+
+printf "%-40s %10s %10s %8s\n" "dataset:minutil" "static" "adaptive" "speedup"
+for arg in "$@"; do
+    dataset=${arg%:*}
+    minutil=${arg##*:}
+    best_static=
+    best_adaptive=
+    for _ in $(seq "$REPEAT"); do
+        t=$(search_ms "$dataset" "$minutil")
+        if [ -z "$best_static" ] || [ "$t" -lt "$best_static" ]; then best_static=$t; fi
+        t=$(search_ms "$dataset" "$minutil" --adaptive-thresholds)
+        if [ -z "$best_adaptive" ] || [ "$t" -lt "$best_adaptive" ]; then best_adaptive=$t; fi
+    done
+    speedup=$(awk -v a="$best_static" -v b="$best_adaptive" 'BEGIN {printf "%.2f", b ? a / b : 0}')
+    printf "%-40s %8s ms %8s ms %7sx\n" "$arg" "$best_static" "$best_adaptive" "$speedup"
+done
@@ -0,0 +1,167 @@
+// Parse throughput of the line-based decoder (memchr + stripLine + decodeTransaction)
+// and the block tokenizer on a synthetic Kosarak-like database.
+//
+//   $ ./tokenizer_bench [# of transactions] [input file]
+
+#include <dphim/parse.hpp>
+#include <dphim/tokenizer.hpp>
+#include <dphim/util/mapped_file.hpp>
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::string makeKosarakLike(std::size_t transaction_num) {
+    std::mt19937_64 rng(0);
+    std::geometric_distribution<int> len_dist(1.0 / 8);// Kosarak: 8.1 items per transaction on average
+    std::uniform_int_distribution<dphim::Item> item_dist(1, 41270);
+    std::uniform_int_distribution<int> util_dist(1, 30);
+    std::string text;
+    for (std::size_t t = 0; t < transaction_num; ++t) {
+        auto len = 1 + len_dist(rng);
+        std::vector<int> utils;
+        dphim::Utility tu = 0;
+        for (int i = 0; i < len; ++i) {
+            text += std::to_string(item_dist(rng));
+            text += i + 1 < len ? " " : ":";
+            utils.push_back(util_dist(rng));
+            tu += utils.back();
+        }
+        text += std::to_string(tu) + ":";
+        for (int i = 0; i < len; ++i) {
+            text += std::to_string(utils[i]);
+            text += i + 1 < len ? " " : "\n";
+        }
+    }
+    return text;
+}
+
+// the parser before the block tokenizer: find_first_of for comments and std::stol per field
+dphim::Transaction parseWithStol(const std::string &line) {
+    std::size_t i = 0, j = 0;
+    std::vector<std::pair<dphim::Item, dphim::Utility>> buf;
+    while (i < line.size()) {
+        auto item = static_cast<dphim::Item>(std::stol(line.data() + i, &j));
+        i += j + 1;
+        buf.emplace_back(item, 0);
+        if (line[i - 1] == ':')
+            break;
+    }
+    dphim::Transaction tra;
+    tra.reserve(buf.size());
+    for (auto &&e: buf)
+        tra.push_back(std::move(e));
+    tra.transaction_utility = static_cast<dphim::Utility>(std::stol(line.data() + i, &j));
+    i += j + 1;
+    for (auto &[item, util]: tra) {
+        util = static_cast<dphim::Utility>(std::stol(line.data() + i, &j));
+        i += j + 1;
+    }
+    return tra;
+}
+
+template<typename F>
+double measure(const std::string &name, std::size_t bytes, F &&f) {
+    double best = 1e100;
+    std::size_t result = 0;
+    for (int rep = 0; rep < 5; ++rep) {
+        auto bg = std::chrono::steady_clock::now();
+        result = f();
+        auto sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - bg).count();
+        best = std::min(best, sec);
+    }
+    auto mbps = bytes / best / 1e6;
+    std::cout << name << ": " << mbps << " MB/s (checksum " << result << ")" << std::endl;
+    return mbps;
+}
+
+}// namespace
+
+int main(int argc, char *argv[]) {
+    using namespace dphim;
+    std::size_t transaction_num = argc > 1 ? std::stoul(argv[1]) : 1000000;
+    std::string text;
+    if (argc > 2) {
+        MappedFile file(argv[2]);
+        text.assign(file.begin(), file.end());
+    } else {
+        text = makeKosarakLike(transaction_num);
+    }
+    const char *bg = text.data(), *ed = text.data() + text.size();
+    std::cout << "input: " << text.size() << " bytes" << std::endl;
+
+    auto checksum = [](const Transaction &tra) {
+        std::size_t s = tra.transaction_utility;
+        for (auto &[item, util]: tra)
+            s += item * 31 + util;
+        return s;
+    };
+    auto reserve = [](Transaction &t, std::size_t n) { t.reserve(n); };
+
+    auto legacy = measure("line (find_first_of + std::stol)", text.size(), [&] {
+        std::size_t sum = 0;
+        std::string line;
+        for (const char *prev = bg; prev < ed;) {
+            const auto *p = static_cast<const char *>(std::memchr(prev, '\n', ed - prev));
+            if (!p)
+                p = ed;
+            line.assign(prev, p);
+            prev = p + 1;
+            if (auto comment_pos = line.find_first_of("%#@"); comment_pos != std::string::npos)
+                line.erase(comment_pos);
+            if (line.empty())
+                continue;
+            sum += checksum(parseWithStol(line));
+        }
+        return sum;
+    });
+
+    auto base = measure("line (memchr + stripLine + from_chars)", text.size(), [&] {
+        std::size_t sum = 0;
+        for (const char *prev = bg; prev < ed;) {
+            const auto *p = static_cast<const char *>(std::memchr(prev, '\n', ed - prev));
+            if (!p)
+                p = ed;
+            auto line = stripLine({prev, static_cast<std::size_t>(p - prev)});
+            prev = p + 1;
+            if (line.empty())
+                continue;
+            Transaction tra;
+            decodeTransaction(line, tra, reserve);
+            sum += checksum(tra);
+        }
+        return sum;
+    });
+
+    for (std::string isa: {"scalar", "sse4.2", "avx2"}) {
+        ClassifyBlockFn classify;
+        try {
+            classify = getClassifyBlock(isa);
+        } catch (std::exception &e) {
+            std::cout << isa << ": not supported" << std::endl;
+            continue;
+        }
+        TokenizedLines tl;
+        measure("tokenize only (" + isa + ")", text.size(), [&] {
+            tokenizeLines(bg, ed, tl, classify);
+            return tl.starts.size();
+        });
+        auto mbps = measure("tokenize + decode (" + isa + ")", text.size(), [&] {
+            std::size_t sum = 0;
+            tokenizeLines(bg, ed, tl, classify);
+            for (auto &line: tl.lines) {
+                Transaction tra;
+                decodeTokenizedTransaction(tl, line, ed, tra, reserve);
+                sum += checksum(tra);
+            }
+            return sum;
+        });
+        std::cout << "  speedup: " << mbps / legacy << "x over std::stol, " << mbps / base << "x over from_chars" << std::endl;
+    }
+    std::cout << "selected at runtime: " << getClassifyBlockName(getClassifyBlock()) << std::endl;
+}
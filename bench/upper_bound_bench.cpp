@@ -0,0 +1,123 @@
+// Throughput of the upper-bound kernels of the search phase: binary search of each element in the items to keep and
+// the dense item mask (including building the mask once per search node), on synthetic projected transactions.
+//
+//   $ ./upper_bound_bench [# of items] [# of transactions per search node] [# of search nodes]
+
+#include <dphim/transaction.hpp>
+#include <dphim/upper_bounds.hpp>
+#include <dphim/utility_bin_array.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Node {
+    std::vector<dphim::Item> itemsToKeep;
+    std::vector<dphim::Transaction> transactions;
+};
+
+// transactions of `len` items on average out of `item_num` items, `keep_percent` % of which are kept
+std::vector<Node> makeNodes(std::size_t node_num, std::size_t transaction_num, dphim::Item item_num, int len,
+                            int keep_percent) {
+    std::mt19937_64 rng(0);
+    std::geometric_distribution<int> len_dist(1.0 / len);
+    std::uniform_int_distribution<dphim::Item> item_dist(1, item_num);
+    std::uniform_int_distribution<int> percent_dist(0, 99);
+    std::uniform_int_distribution<dphim::Utility> util_dist(1, 30);
+    std::vector<Node> nodes(node_num);
+    for (auto &node: nodes) {
+        for (dphim::Item i = 1; i <= item_num; ++i)
+            if (percent_dist(rng) < keep_percent)
+                node.itemsToKeep.push_back(i);
+        if (node.itemsToKeep.empty())
+            node.itemsToKeep.push_back(item_num);
+        for (std::size_t t = 0; t < transaction_num; ++t) {
+            std::vector<dphim::Item> items(1 + len_dist(rng));
+            for (auto &item: items)
+                item = item_dist(rng);
+            std::sort(items.begin(), items.end());
+            items.erase(std::unique(items.begin(), items.end()), items.end());
+            // projected transactions have no items before the first item to keep
+            std::erase_if(items, [&node](auto item) { return item < node.itemsToKeep.front(); });
+            dphim::Transaction tra;
+            tra.reserve(items.size());
+            for (auto item: items) {
+                tra.push_back({item, util_dist(rng)});
+                tra.transaction_utility += tra.rbegin()->second;
+            }
+            tra.prefix_utility = util_dist(rng);
+            node.transactions.push_back(std::move(tra));
+        }
+    }
+    return nodes;
+}
+
+template<typename F>
+double measure(const std::string &name, std::size_t elems, F &&f) {
+    double best = 1e100;
+    dphim::Utility result = 0;
+    for (int rep = 0; rep < 5; ++rep) {
+        auto bg = std::chrono::steady_clock::now();
+        result = f();
+        auto sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - bg).count();
+        best = std::min(best, sec);
+    }
+    auto ns = best * 1e9 / elems;
+    std::cout << "  " << name << ": " << ns << " ns/element (checksum " << result << ")" << std::endl;
+    return ns;
+}
+
+}// namespace
+
+int main(int argc, char *argv[]) {
+    using namespace dphim;
+    Item item_num = argc > 1 ? std::stoul(argv[1]) : 10000;
+    std::size_t transaction_num = argc > 2 ? std::stoul(argv[2]) : 1000;
+    std::size_t node_num = argc > 3 ? std::stoul(argv[3]) : 100;
+
+    for (int len: {8, 64}) {
+        for (int keep_percent: {5, 30, 90}) {
+            auto nodes = makeNodes(node_num, transaction_num, item_num, len, keep_percent);
+            std::size_t elems = 0;
+            for (auto &node: nodes)
+                for (auto &tra: node.transactions)
+                    elems += tra.size();
+            std::cout << "length ~" << len << ", " << keep_percent << "% of " << item_num << " items kept:" << std::endl;
+
+            auto checksum = [](const UtilityBinArray &ub, const std::vector<Item> &itemsToKeep) {
+                Utility sum = 0;
+                for (auto item: itemsToKeep)
+                    sum += ub.getLU(item) + ub.getSU(item);
+                return sum;
+            };
+            UtilityBinArray ub;
+            auto search = measure("binary search", elems, [&] {
+                Utility sum = 0;
+                for (auto &node: nodes) {
+                    ub.reset(node.itemsToKeep.front(), node.itemsToKeep.back());
+                    for (auto &tra: node.transactions)
+                        addUpperBounds(ub, tra, node.itemsToKeep);
+                    sum += checksum(ub, node.itemsToKeep);
+                }
+                return sum;
+            });
+            auto mask = measure("item mask", elems, [&] {
+                Utility sum = 0;
+                for (auto &node: nodes) {
+                    ub.reset(node.itemsToKeep.front(), node.itemsToKeep.back());
+                    ItemMask itemMask(node.itemsToKeep.begin(), node.itemsToKeep.end());
+                    for (auto &tra: node.transactions)
+                        addUpperBounds(ub, tra, itemMask);
+                    sum += checksum(ub, node.itemsToKeep);
+                }
+                return sum;
+            });
+            std::cout << "  speedup: " << search / mask << "x" << std::endl;
+        }
+    }
+}
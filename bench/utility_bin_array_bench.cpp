@@ -0,0 +1,76 @@
+// Throughput of the utility bin array kernels (adding bin arrays and selecting the items to keep / explore) of each
+// instruction set, for lists of items of several lengths.
+//
+//   $ ./utility_bin_array_bench [# of repetitions]
+
+#include <dphim/utility_bin_array.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+template<typename F>
+double measure(std::size_t reps, F &&f) {
+    double best = 1e100;
+    for (std::size_t rep = 0; rep < reps; ++rep) {
+        auto bg = std::chrono::steady_clock::now();
+        f();
+        best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - bg).count());
+    }
+    return best;
+}
+
+template<typename U>
+void run(std::size_t reps) {
+    using namespace dphim;
+    std::mt19937_64 rng(0);
+    for (std::size_t range: {16, 64, 1024, 16384}) {
+        // LU and SU of each item next to each other, half of the items kept, a third of them promising
+        std::vector<U> bins(2 * range), other(2 * range);
+        for (auto &b: bins)
+            b = rng() % 300;
+        for (auto &b: other)
+            b = rng() % 300;
+        std::vector<Item> items;
+        for (Item i = 0; i < range; ++i)
+            if (rng() % 2)
+                items.push_back(i);
+        std::vector<Item> newK(items.size()), newE(items.size());
+        std::vector<U> sum(bins.size());
+
+        std::cout << sizeof(U) * 8 << "-bit utilities, " << range << " items:" << std::endl;
+        for (std::string isa: {"scalar", "avx2", "avx512"}) {
+            const UtilityBinArrayKernels<U> *kernels;
+            try {
+                kernels = &getUtilityBinArrayKernels<U>(isa);
+            } catch (std::exception &e) {
+                std::cout << "  " << isa << ": not supported" << std::endl;
+                continue;
+            }
+            std::size_t selected = 0;
+            auto select = measure(reps, [&] {
+                auto [k, e] = kernels->select(items.data(), items.size(), 0, bins.data(), U(200), newK.data(), newE.data());
+                selected = k + e;
+            });
+            auto add = measure(reps, [&] { kernels->add(sum.data(), other.data(), sum.size()); });
+            std::cout << "  " << isa << ": select " << select * 1e9 / std::max<std::size_t>(items.size(), 1)
+                      << " ns/item (" << selected << " selected), add " << add * 1e9 / bins.size() << " ns/bin"
+                      << std::endl;
+        }
+    }
+}
+
+}// namespace
+
+int main(int argc, char *argv[]) {
+    std::size_t reps = argc > 1 ? std::stoul(argv[1]) : 1000;
+    run<std::uint32_t>(reps);
+    run<std::uint64_t>(reps);
+    std::cout << "selected at runtime: " << dphim::getUtilityBinArrayKernels<dphim::Utility>().name << std::endl;
+}
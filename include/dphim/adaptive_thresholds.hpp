@@ -0,0 +1,162 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <ostream>
+#include <vector>
+
+namespace dphim {
+
+// Online cost model that adjusts the thresholds of the search step from what the search measures, starting from the
+// static thresholds (hints):
+//  * spawn: a child is searched as a task that idle workers can steal only if the database it projects has at least
+//    spawn_min_bytes. The bound is doubled while few spawned tasks are stolen and halved while many are.
+//  * migrate: a task moves to the node of a partition larger than task_migration_threshold, which is the delay of a
+//    migration divided by the extra scan time per byte of a remote partition (scans of sample_min_bytes or more are
+//    timed, and 1 of explore_interval migrations is skipped to keep timing remote scans).
+//  * scatter: scatter_alloc_threshold is halved while the bytes allocated on each node are imbalanced, and doubled
+//    while they are balanced.
+// Thresholds are updated every window of samples by the thread that completes it; updates may race, but each of them
+// is a valid value.
+struct AdaptiveThresholds {
+    using clock = std::chrono::steady_clock;
+
+    static constexpr std::size_t sample_min_bytes = 64ul << 10;
+    static constexpr std::size_t explore_interval = 32;
+
+    AdaptiveThresholds(std::size_t task_migration_hint, std::size_t scatter_alloc_hint, std::size_t node_num)
+        : task_migration_hint(task_migration_hint), scatter_alloc_hint(scatter_alloc_hint),
+          task_migration_threshold(task_migration_hint), scatter_alloc_threshold(scatter_alloc_hint),
+          alloc_bytes(std::max<std::size_t>(node_num, 1)) {}
+
+    bool shouldSpawn(std::size_t bytes) const {
+        return bytes >= spawn_min_bytes.load(std::memory_order_relaxed);
+    }
+
+    // whether to migrate to a partition of `bytes` (unless the migration is skipped to time a remote scan)
+    bool shouldMigrate(std::size_t bytes) {
+        if (bytes <= task_migration_threshold.load(std::memory_order_relaxed))
+            return false;
+        return bytes < sample_min_bytes || migration_count.fetch_add(1, std::memory_order_relaxed) % explore_interval != 0;
+    }
+
+    std::size_t getScatterAllocThreshold() const {
+        return scatter_alloc_threshold.load(std::memory_order_relaxed);
+    }
+
+    // a spawned task resumed (on another thread if `stolen`)
+    void addSpawn(bool stolen) {
+        if (stolen)
+            stolen_count.fetch_add(1, std::memory_order_relaxed);
+        if (spawn_count.fetch_add(1, std::memory_order_relaxed) + 1 < spawn_window)
+            return;
+        spawn_count.store(0, std::memory_order_relaxed);
+        auto stolen_in_window = stolen_count.exchange(0, std::memory_order_relaxed);
+        auto bound = spawn_min_bytes.load(std::memory_order_relaxed);
+        if (stolen_in_window * 64 < spawn_window)
+            bound = std::min(std::max(bound * 2, min_spawn_min_bytes), max_spawn_min_bytes);
+        else if (stolen_in_window * 8 > spawn_window)
+            bound = bound > min_spawn_min_bytes ? bound / 2 : 0;// 0: every child is spawned
+        spawn_min_bytes.store(bound, std::memory_order_relaxed);
+    }
+
+    // a scan of a partition of `bytes` took `time` (on another node if `remote`)
+    void addScan(std::size_t bytes, clock::duration time, bool remote) {
+        auto &s = remote ? remote_scan : local_scan;
+        s.bytes.fetch_add(bytes, std::memory_order_relaxed);
+        s.ns.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(time).count(), std::memory_order_relaxed);
+        if (s.count.fetch_add(1, std::memory_order_relaxed) % scan_window == scan_window - 1)
+            updateMigration();
+    }
+
+    // a migration delayed a task by `time`
+    void addMigration(clock::duration time) {
+        migration_ns.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(time).count(), std::memory_order_relaxed);
+        migration_samples.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void addAlloc(std::size_t node, std::size_t bytes) {
+        alloc_bytes[node % alloc_bytes.size()].fetch_add(bytes, std::memory_order_relaxed);
+        auto total = alloc_total.fetch_add(bytes, std::memory_order_relaxed);
+        if (total / alloc_window != (total + bytes) / alloc_window)
+            updateScatter();
+    }
+
+    void print(std::ostream &out) const {
+        out << "Adaptive thresholds: " << std::endl;
+        out << "  spawn_min_bytes: " << spawn_min_bytes.load() << std::endl;
+        out << "  task_migration_threshold: " << task_migration_threshold.load() << " (hint " << task_migration_hint
+            << ")" << std::endl;
+        out << "  scatter_alloc_threshold: " << scatter_alloc_threshold.load() << " (hint " << scatter_alloc_hint
+            << ")" << std::endl;
+    }
+
+private:
+    static constexpr std::size_t spawn_window = 256;
+    static constexpr std::size_t min_spawn_min_bytes = 1ul << 10;
+    static constexpr std::size_t max_spawn_min_bytes = 1ul << 20;
+    static constexpr std::size_t scan_window = 16;
+    static constexpr std::size_t alloc_window = 4ul << 20;
+    static constexpr std::size_t hint_range = 64;// thresholds stay within [hint / hint_range, hint * hint_range]
+
+    struct ScanStats {
+        std::atomic<std::size_t> bytes = 0, ns = 0, count = 0;
+
+        double nsPerByte() const {
+            auto b = bytes.load(std::memory_order_relaxed);
+            return b ? double(ns.load(std::memory_order_relaxed)) / double(b) : 0;
+        }
+    };
+
+    static std::size_t clamp(double value, std::size_t hint) {
+        auto lo = std::max<std::size_t>(hint / hint_range, 1);
+        return static_cast<std::size_t>(std::clamp(value, double(lo), double(hint * hint_range)));
+    }
+
+    void updateMigration() {
+        auto samples = migration_samples.load(std::memory_order_relaxed);
+        if (local_scan.count.load(std::memory_order_relaxed) < scan_window ||
+            remote_scan.count.load(std::memory_order_relaxed) < scan_window || samples == 0)
+            return;
+        auto penalty = remote_scan.nsPerByte() - local_scan.nsPerByte();
+        auto delay = double(migration_ns.load(std::memory_order_relaxed)) / double(samples);
+        // remote scans that are not slower make migrations useless (except for huge partitions)
+        auto threshold = penalty > 0 ? delay / penalty : double(task_migration_hint * hint_range);
+        task_migration_threshold.store(clamp(threshold, task_migration_hint), std::memory_order_relaxed);
+    }
+
+    void updateScatter() {
+        std::size_t max = 0, sum = 0;
+        for (auto &b: alloc_bytes) {
+            auto v = b.load(std::memory_order_relaxed);
+            max = std::max(max, v);
+            sum += v;
+        }
+        if (alloc_bytes.size() < 2 || sum == 0)
+            return;
+        // max / mean of the bytes per node
+        auto imbalance = double(max) * double(alloc_bytes.size()) / double(sum);
+        auto threshold = double(scatter_alloc_threshold.load(std::memory_order_relaxed));
+        if (imbalance > 1.5)
+            threshold /= 2;
+        else if (imbalance < 1.1)
+            threshold *= 2;
+        scatter_alloc_threshold.store(clamp(threshold, scatter_alloc_hint), std::memory_order_relaxed);
+    }
+
+    const std::size_t task_migration_hint, scatter_alloc_hint;
+
+    std::atomic<std::size_t> spawn_min_bytes = 0;
+    std::atomic<std::size_t> task_migration_threshold;
+    std::atomic<std::size_t> scatter_alloc_threshold;
+
+    std::atomic<std::size_t> spawn_count = 0, stolen_count = 0;
+    ScanStats local_scan, remote_scan;
+    std::atomic<std::size_t> migration_count = 0, migration_ns = 0, migration_samples = 0;
+    std::vector<std::atomic<std::size_t>> alloc_bytes;
+    std::atomic<std::size_t> alloc_total = 0;
+};
+
+}// namespace dphim
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <dphim/transaction.hpp>
+#include <dphim/util/mapped_file.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace dphim {
+
+// Binary on-disk database in CSR layout.
+//
+//   header | offsets[transaction_num + 1] | items[elem_num] | utilities[elem_num] | transaction_utilities[transaction_num]
+//
+// Elements of the i-th transaction are items[offsets[i]..offsets[i+1]) and utilities[offsets[i]..offsets[i+1]).
+// Every section starts at a multiple of `section_alignment` so that it can be used directly from a read-only mapping.
+struct BinaryDatabaseHeader {
+    static constexpr char magic_value[8] = {'D', 'P', 'H', 'I', 'M', 'D', 'B', '\0'};
+    static constexpr std::uint32_t current_version = 1;
+    static constexpr std::uint64_t section_alignment = 64;
+
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t item_bytes;
+    std::uint32_t utility_bytes;
+    std::uint32_t reserved;
+    std::uint64_t transaction_num;
+    std::uint64_t elem_num;
+    std::uint64_t max_item;
+    std::uint64_t offsets_pos;
+    std::uint64_t items_pos;
+    std::uint64_t utilities_pos;
+    std::uint64_t transaction_utilities_pos;
+    std::uint64_t file_size;
+
+    static BinaryDatabaseHeader make(std::uint64_t transaction_num, std::uint64_t elem_num, Item max_item) {
+        auto align = [](std::uint64_t pos) {
+            return (pos + section_alignment - 1) / section_alignment * section_alignment;
+        };
+        BinaryDatabaseHeader h{};
+        std::memcpy(h.magic, magic_value, sizeof(magic_value));
+        h.version = current_version;
+        h.item_bytes = sizeof(Item);
+        h.utility_bytes = sizeof(Utility);
+        h.transaction_num = transaction_num;
+        h.elem_num = elem_num;
+        h.max_item = max_item;
+        h.offsets_pos = align(sizeof(BinaryDatabaseHeader));
+        h.items_pos = align(h.offsets_pos + sizeof(std::uint64_t) * (transaction_num + 1));
+        h.utilities_pos = align(h.items_pos + sizeof(Item) * elem_num);
+        h.transaction_utilities_pos = align(h.utilities_pos + sizeof(Utility) * elem_num);
+        h.file_size = h.transaction_utilities_pos + sizeof(Utility) * transaction_num;
+        return h;
+    }
+};
+
+// true if the file starts with the magic number of the binary database format
+bool isBinaryDatabase(const std::string &path);
+
+// Read-only view of a binary database file. The file is mapped, and only its offsets and items are read up front,
+// to validate them (the constructor throws std::runtime_error on a corrupt file).
+struct BinaryDatabase {
+    explicit BinaryDatabase(const std::string &path);
+
+    std::size_t size() const noexcept { return header->transaction_num; }
+    std::size_t elem_num() const noexcept { return header->elem_num; }
+    Item max_item() const noexcept { return static_cast<Item>(header->max_item); }
+
+    std::size_t transaction_size(std::size_t i) const noexcept { return offsets[i + 1] - offsets[i]; }
+    // number of elements in transactions [bg, ed)
+    std::size_t elem_num(std::size_t bg, std::size_t ed) const noexcept { return offsets[ed] - offsets[bg]; }
+    const std::uint64_t *get_offsets() const noexcept { return offsets; }
+
+    // copy the i-th transaction into `tra`, which must already have room for transaction_size(i) elements
+    void fill(std::size_t i, Transaction &tra) const {
+        for (auto k = offsets[i]; k < offsets[i + 1]; ++k)
+            tra.push_back(Transaction::Elem{items[k], utilities[k]});
+        tra.transaction_utility = transaction_utilities[i];
+    }
+
+    Transaction get(std::size_t i) const {
+        Transaction tra;
+        tra.reserve(transaction_size(i));
+        fill(i, tra);
+        return tra;
+    }
+
+private:
+    MappedFile file;
+    const BinaryDatabaseHeader *header = nullptr;
+    const std::uint64_t *offsets = nullptr;
+    const Item *items = nullptr;
+    const Utility *utilities = nullptr;
+    const Utility *transaction_utilities = nullptr;
+};
+
+// Write transactions (any range of Transaction) in the binary database format.
+template<typename Range>
+void writeBinaryDatabase(const std::string &path, const Range &transactions, Item max_item) {
+    std::uint64_t transaction_num = 0, elem_num = 0;
+    for (const auto &tra: transactions) {
+        transaction_num += 1;
+        elem_num += tra.size();
+    }
+    auto header = BinaryDatabaseHeader::make(transaction_num, elem_num, max_item);
+
+    std::ofstream out(path, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!out)
+        throw std::runtime_error("failed to open output (" + path + ")");
+
+    auto seek = [&out](std::uint64_t pos) {
+        for (auto cur = static_cast<std::uint64_t>(out.tellp()); cur < pos; ++cur)
+            out.put('\0');
+    };
+    auto write = [&out](const auto &v) {
+        out.write(reinterpret_cast<const char *>(&v), sizeof(v));
+    };
+
+    write(header);
+
+    seek(header.offsets_pos);
+    std::uint64_t offset = 0;
+    write(offset);
+    for (const auto &tra: transactions) {
+        offset += tra.size();
+        write(offset);
+    }
+
+    seek(header.items_pos);
+    for (const auto &tra: transactions)
+        for (const auto &[item, util]: tra)
+            write(item);
+
+    seek(header.utilities_pos);
+    for (const auto &tra: transactions)
+        for (const auto &[item, util]: tra)
+            write(util);
+
+    seek(header.transaction_utilities_pos);
+    for (const auto &tra: transactions)
+        write(tra.transaction_utility);
+
+    if (!out)
+        throw std::runtime_error("failed to write (" + path + ")");
+}
+
+// Convert a database of SPMF format into the binary database format.
+void convertToBinaryDatabase(const std::string &input_path, const std::string &output_path);
+
+}// namespace dphim
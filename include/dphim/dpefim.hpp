@@ -5,12 +5,21 @@
 #include <nova/when_all.hpp>
 #include <nova/worker.hpp>
 
+#include <dphim/adaptive_thresholds.hpp>
 #include <dphim/dphim_base.hpp>
 #include <dphim/logger.hpp>
+#include <dphim/occurrence_index.hpp>
+#include <dphim/upper_bounds.hpp>
+#include <dphim/util/arena.hpp>
+#include <dphim/util/merge_table.hpp>
 #include <dphim/util/pmem_allocator.hpp>
 #include <dphim/utility_bin_array.hpp>
 #include <nova/jemalloc.hpp>
 
+#include <span>
+#include <thread>
+#include <tuple>
+
 // #define NOINLINE __attribute__((noinline))
 #define NOINLINE
 
@@ -37,6 +46,117 @@ struct DPEFIM : DphimBase {
         }
     }
 
+    // directory of snapshots of the Build step (disabled if empty)
+    std::string snapshot_dir;
+
+    void set_snapshot_dir(const std::string &dir) {
+        snapshot_dir = dir;
+    }
+
+    // merge transactions with the same items into one in the Build step
+    bool merge_duplicates = true;
+
+    void set_merge_duplicates(bool flag) {
+        merge_duplicates = flag;
+    }
+
+    // search with the narrowest item/utility types that can hold the database after the Build step
+    bool narrow_types = true;
+
+    void set_narrow_types(bool flag) {
+        narrow_types = flag;
+    }
+
+    // allocate merged transactions of each projected database in arenas, and make projections views of
+    // their parents (each projected database outlives none of its ancestors), instead of reference counting
+    bool use_arena = true;
+
+    void set_use_arena(bool flag) {
+        use_arena = flag;
+    }
+
+    // calculate upper bounds of the extensions of a prefix while projecting its database of at least
+    // fused_upper_bounds_min_bytes, instead of scanning the projected database again. Smaller projected databases
+    // are still in cache after projecting, and updating upper bounds in between only evicts the parent.
+    // Off by default: it saves a scan only when the projected database does not fit in cache (or is remote).
+    bool fused_upper_bounds = false;
+    std::size_t fused_upper_bounds_min_bytes = 1ul << 20;
+
+    void set_fused_upper_bounds(bool flag) {
+        fused_upper_bounds = flag;
+    }
+
+    // look up items to keep in a mask over [itemsToKeep[j], itemsToKeep.back()] when calculating upper bounds,
+    // instead of searching for each element of each projected transaction in itemsToKeep
+    bool use_item_mask = true;
+
+    void set_use_item_mask(bool flag) {
+        use_item_mask = flag;
+    }
+
+    // index the positions of items in partitions of a database with at least occurrence_index_min_bytes, searched
+    // for at least occurrence_index_min_items items, so that each child visits only transactions containing its item
+    bool use_occurrence_index = true;
+    std::size_t occurrence_index_min_bytes = 256ul << 10;
+    std::size_t occurrence_index_min_items = 8;
+
+    void set_use_occurrence_index(bool flag) {
+        use_occurrence_index = flag;
+    }
+
+    // # of sibling items whose projected databases are made by one scan of their parent, which then stays in cache
+    // (1: every child scans the parent by itself). Projected databases of a batch are alive at the same time.
+    std::size_t batch_siblings = 1;
+
+    void set_batch_siblings(std::size_t n) {
+        batch_siblings = std::max<std::size_t>(n, 1);
+    }
+
+    // merge projected transactions with the same extension even if they are not adjacent (see MergeTable)
+    bool hash_merge = false;
+
+    void set_hash_merge(bool flag) {
+        hash_merge = flag;
+    }
+
+    // copy each partition of a projected database with [flatten_min_bytes, flatten_max_bytes] bytes of elements
+    // into one buffer, so that its children scan it sequentially instead of following pointers into the buffers
+    // of its ancestors. Smaller ones stay in cache anyway, and larger ones would double the memory footprint.
+    std::size_t flatten_min_bytes = 32ul << 10;
+    std::size_t flatten_max_bytes = 0;// disabled
+
+    void set_flatten_bytes(std::size_t min_bytes, std::size_t max_bytes) {
+        flatten_min_bytes = min_bytes;
+        flatten_max_bytes = max_bytes;
+    }
+
+    // when a projected database is the only one made from its parent (a chain of single extensions), copy it into
+    // fresh buffers and release the parent if it holds less than `compaction_ratio` of the parent's bytes
+    // (and the parent has at least compaction_min_bytes), instead of pinning the parent until the chain ends
+    double compaction_ratio = 0.25;// 0: disabled
+    std::size_t compaction_min_bytes = 1ul << 20;
+
+    void set_compaction_ratio(double ratio) {
+        compaction_ratio = ratio;
+    }
+
+    // search the subtree of a prefix by plain recursion on the current thread (without a task nor a coroutine frame
+    // per search node) if the bytes of its projected database times the # of its items to explore, which its
+    // children scan, are at most sequential_cutoff_bytes. Such subtrees are too small to be worth stealing.
+    std::size_t sequential_cutoff_bytes = 64ul << 10;// 0: disabled
+
+    void set_sequential_cutoff(std::size_t bytes) {
+        sequential_cutoff_bytes = bytes;
+    }
+
+    // adjust the spawn, task migration and scatter allocation thresholds of the search step online, starting from
+    // the step3 ones of `thresholds` (see AdaptiveThresholds)
+    bool use_adaptive_thresholds = false;
+
+    void set_adaptive_thresholds(bool flag) {
+        use_adaptive_thresholds = flag;
+    }
+
     friend std::ostream &operator<<(std::ostream &os, const ScatterType &st) {
         switch (st) {
             case ScatterType::None:
@@ -57,7 +177,9 @@ private:
     Utility min_util;
     Item maxItem = 0;
     std::size_t partition_num = 1;
-
+    std::unique_ptr<AdaptiveThresholds> adaptive_thresholds;
+    // SU of each item after the Build step, to select the items to explore of each threshold of a sweep
+    std::vector<Utility> firstSU;
 
 public:
     struct SpeculationThresholds {
@@ -87,31 +209,114 @@ public:
     template<typename D>
     auto calcFirstSU(D &database) -> nova::task<std::vector<Utility>>;
 
+    template<typename I>
+    auto searchNarrowest(Database database, I itemsToKeep, I itemsToExplore) -> nova::task<>;
+
+    template<typename T, typename I>
+    auto searchAs(Database database, I itemsToKeep, I itemsToExplore) -> nova::task<>;
+
+    // search the root database, once per threshold of a sweep if any
+    template<typename D, typename I>
+    auto searchRoot(const D &database, I itemsToKeep, I itemsToExplore) -> nova::task<>;
+
+    // utility of a prefix, its projected database, and the upper bounds of its extensions (empty if not calculated)
+    template<typename Tra>
+    using Projection = std::tuple<Utility, BasicDatabase<Tra>, BasicUtilityBinArray<typename Tra::utility_type>>;
+
+    template<typename Tra>
+    struct Projector;
+
+    // visit only transactions in `index` if specified.
+    // The upper bounds of itemsToKeep (see calcUpperBoundsImpl()) are also calculated unless itemsToKeep is empty
     template<typename T>
-    auto calcUtilityAndNextDB(Item x, T &&db, int node = -1, bool allow_scatter = false) -> std::pair<Utility, Database>;
+    auto calcUtilityAndNextDB(Item x, T &&db, int node = -1, bool allow_scatter = false, const OccurrenceIndex *index = nullptr,
+                              std::span<const Item> itemsToKeep = {}, std::size_t j = 0)
+            -> Projection<typename std::remove_cvref_t<T>::value_type>;
+
+    // calcUtilityAndNextDB() with every item in `xs` (itemsToExplore[j, j + xs.size()) in ascending order) by one scan of `db`
+    template<typename T, typename I>
+    auto calcUtilitiesAndNextDBs(const I &xs, T &&db, int node = -1, bool allow_scatter = false,
+                                 std::span<const Item> itemsToKeep = {}, std::size_t j = 0)
+            -> std::vector<Projection<typename std::remove_cvref_t<T>::value_type>>;
 
     template<typename D, typename I>
     auto search(const I &prefix, const D &transactionsOfP, I &&itemsToKeep, I &&itemsToExplore) {
         incCandidateCount(itemsToExplore.size());
+        if (batch_siblings > 1 && itemsToExplore.size() > 1) {
+            std::vector<nova::task<>> tasks;
+            for (std::size_t bg = 0; bg < itemsToExplore.size(); bg += batch_siblings) {
+                auto ed = std::min(bg + batch_siblings, itemsToExplore.size());
+                tasks.emplace_back(searchBatch(bg, ed, prefix, transactionsOfP, itemsToKeep, itemsToExplore));
+            }
+            return nova::when_all(std::move(tasks));
+        }
+        // shared by the children, and built for partitions large enough when one of them needs it
+        std::shared_ptr<LazyOccurrenceIndexes> index;
+        if (use_occurrence_index && itemsToExplore.size() >= occurrence_index_min_items)
+            index = std::make_shared<LazyOccurrenceIndexes>(transactionsOfP.partition_num());
         std::vector<nova::task<>> tasks;
         tasks.reserve(itemsToExplore.size());
         for (int j = 0; j < int(itemsToExplore.size()); ++j) {
-            tasks.emplace_back(searchX(j, prefix, transactionsOfP, itemsToKeep, itemsToExplore));
+            tasks.emplace_back(searchX(j, prefix, transactionsOfP, itemsToKeep, itemsToExplore, index));
         }
         return nova::when_all(std::move(tasks));
     }
 
+    // transactionsOfP is released while searching if it is passed as an rvalue (see compaction_ratio).
+    // `projected` is the projection of transactionsOfP with itemsToExplore[j] if already calculated
     template<typename D, typename I, typename I2>
-    auto searchX(int j, I &&prefix, const D &transactionsOfP, I2 &&itemsToKeep, I2 &&itemsToExplore) -> nova::task<>;
+    auto searchX(int j, I &&prefix, D &&transactionsOfP, I2 &&itemsToKeep, I2 &&itemsToExplore,
+                 std::shared_ptr<LazyOccurrenceIndexes> index = nullptr,
+                 std::optional<Projection<typename std::remove_cvref_t<D>::value_type>> projected = std::nullopt)
+            -> nova::task<>;
+
+    // project transactionsOfP with itemsToExplore[bg, ed) at once (see batch_siblings) and search them
+    template<typename D, typename I>
+    auto searchBatch(std::size_t bg, std::size_t ed, const I &prefix, const D &transactionsOfP,
+                     const I &itemsToKeep, const I &itemsToExplore) -> nova::task<>;
+
+    // search() and searchX() by plain recursion (see sequential_cutoff_bytes).
+    // Each extension is pushed to `prefix` while its subtree is searched
+    template<typename P, typename D, typename I>
+    void searchSequential(P &prefix, const D &transactionsOfP, const I &itemsToKeep, const I &itemsToExplore);
+
+    template<typename P, typename D, typename I>
+    void searchXSequential(std::size_t j, P &prefix, const D &transactionsOfP, const I &itemsToKeep,
+                           const I &itemsToExplore);
 
     template<typename D, typename I>
-    void calcUpperBoundsImpl(UtilityBinArray &ub, std::size_t j, const D &db, const I &itemsToKeep) const;
+    bool shouldSearchSequentially(const D &transactionsOfP, const I &itemsToExplore) const {
+        return sequential_cutoff_bytes != 0 && sumBytes(transactionsOfP) * itemsToExplore.size() <= sequential_cutoff_bytes;
+    }
+
+    // itemsToKeep[j..] are searched for by binary search if `mask` is empty (see use_item_mask)
+    template<typename UB, typename D, typename I>
+    void calcUpperBoundsImpl(UB &ub, std::size_t j, const D &db, const I &itemsToKeep, const ItemMask &mask,
+                             std::size_t extension = std::numeric_limits<std::size_t>::max()) const;
+
+    // output the extensions of `prefix` with newE, which are the longest ones allowed by max_length and whose
+    // utilities are their subtree utilities in `ub`
+    template<typename P, typename UB, typename I>
+    void addLastExtensions(P &prefix, const UB &ub, const I &newE) {
+        incCandidateCount(newE.size());
+        for (auto z: newE) {
+            prefix.push_back(newNameToOldNames[z]);
+            addResult(prefix, ub.getSU(z));
+            prefix.pop_back();
+        }
+    }
+
+    template<typename I>
+    ItemMask makeItemMask(std::size_t j, const I &itemsToKeep) const {
+        return use_item_mask ? ItemMask(itemsToKeep.begin() + j, itemsToKeep.end()) : ItemMask();
+    }
 
     template<bool no_use_thread_local, typename D, typename I>
     NOINLINE auto calcUpperBounds(std::size_t j, const D &transactionsPx, const I &itemsToKeep) const
             -> std::conditional_t<no_use_thread_local, UtilityBinArray, UtilityBinArray &>;
 
-    auto cloneTransaction(const Transaction &tra, std::optional<int> node) {
+    template<typename T>
+    auto cloneTransaction(const T &tra, std::optional<int> node) {
         if (pmem_alloc_type != PmemAllocType::None) {
 #ifdef DPHIM_PMEM
             auto pmem_allocator = get_pmem_allocator(node);
@@ -144,6 +349,105 @@ public:
         }
     }
 
+    // arena of transactions merged in calcUtilityAndNextDB() (allocated on `node` if specified)
+    std::shared_ptr<Arena> makeArena(std::optional<int> node) {
+        if (node) {
+            auto cpu = sched->get_corresponding_cpu_id(*node);
+            if (!cpu) {
+                std::cerr << "failed to find corresponding cpu" << std::endl;
+                std::abort();
+            }
+            return std::make_shared<Arena>([cpu](std::size_t sz) { return nova::malloc_on_thread(sz, *cpu); });
+        }
+        return std::make_shared<Arena>();
+    }
+
+    bool shouldSpawn(std::size_t bytes) const {
+        return !adaptive_thresholds || adaptive_thresholds->shouldSpawn(bytes);
+    }
+
+    // a task spawned on thread `spawner` resumed
+    void addSpawn(std::thread::id spawner) const {
+        if (adaptive_thresholds)
+            adaptive_thresholds->addSpawn(std::this_thread::get_id() != spawner);
+    }
+
+    // whether a task at `depth` moves to the node of a partition of `bytes` before scanning it
+    bool shouldMigrate(std::size_t depth, std::size_t bytes) const {
+        if (depth >= thresholds.step3_stop_task_migration_depth)
+            return false;
+        return adaptive_thresholds ? adaptive_thresholds->shouldMigrate(bytes)
+                                   : bytes > thresholds.step3_task_migration_threshold;
+    }
+
+    void addMigration(AdaptiveThresholds::clock::duration time) const {
+        if (adaptive_thresholds)
+            adaptive_thresholds->addMigration(time);
+    }
+
+    std::size_t scatterAllocThreshold() const {
+        return adaptive_thresholds ? adaptive_thresholds->getScatterAllocThreshold()
+                                   : thresholds.step3_scatter_alloc_threshold;
+    }
+
+    void addAlloc(int node, std::size_t bytes) const {
+        if (adaptive_thresholds)
+            adaptive_thresholds->addAlloc(node, bytes);
+    }
+
+    // `scan` partition `node` of a database, timing it if the thresholds are adaptive and `part` is large enough
+    template<typename P, typename F>
+    auto timeScan(const P &part, std::size_t node, F &&scan) const {
+        if (!adaptive_thresholds || part.get_sum_value() < AdaptiveThresholds::sample_min_bytes)
+            return scan();
+        auto bg = AdaptiveThresholds::clock::now();
+        auto ret = scan();
+        auto current = sched->get_current_node_id();
+        adaptive_thresholds->addScan(part.get_sum_value(), AdaptiveThresholds::clock::now() - bg,
+                                     current && *current != static_cast<int>(node));
+        return ret;
+    }
+
+    template<typename P>
+    bool shouldFlatten(const P &part) const {
+        return use_arena && pmem_alloc_type == PmemAllocType::None &&
+               flatten_min_bytes <= part.get_sum_value() && part.get_sum_value() <= flatten_max_bytes;
+    }
+
+    template<typename D>
+    static std::size_t sumBytes(const D &database) {
+        std::size_t ret = 0;
+        for (std::size_t i = 0; i < database.partition_num(); ++i)
+            ret += database.get(i).get_sum_value();
+        return ret;
+    }
+
+    template<typename D>
+    static std::size_t releasableBytes(const D &database) {
+        std::size_t ret = 0;
+        for (std::size_t i = 0; i < database.partition_num(); ++i)
+            for (const auto &tra: database.get(i))
+                ret += tra.releasable_bytes();
+        return ret;
+    }
+
+    template<typename D>
+    bool shouldCompact(const D &projected, const D &parent) const {
+        auto pinned = sumBytes(parent);
+        return pmem_alloc_type == PmemAllocType::None && pinned >= compaction_min_bytes &&
+               sumBytes(projected) < compaction_ratio * pinned;
+    }
+
+    // copy the elements of `part` into one buffer allocated on `node` (the current thread if not specified)
+    template<typename P>
+    void flattenTransactions(P &part, std::optional<int> node) {
+        using Elem = typename P::value_type::Elem;
+        auto arena = makeArena(node);
+        arena->reserve(part.get_sum_value(), alignof(Elem));
+        for (auto &tra: part)
+            tra = tra.clone_into([&arena](std::size_t size) { return arena->allocate(size, alignof(Elem)); }, arena);
+    }
+
     void repartition(Database &database);
     double balanceCheck(const Database &database) const;
 };
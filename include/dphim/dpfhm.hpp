@@ -114,6 +114,9 @@ private:
     std::vector<UtilityList> listOfUtilityLists;
     std::vector<decltype(listOfUtilityLists)::iterator> mapItem2UtilityList;
     PairMap<Utility> mapFMAP;
+    // utilities of 2-itemsets (by the positions of their items in listOfUtilityLists) to raise the threshold of
+    // top-k mode before searching (empty unless top-k mode)
+    PairMap<Utility> mapPairUtility;
 
 public:
     auto greaterItem(Item l, Item r) -> bool {
@@ -184,7 +187,7 @@ public:
         Utility remainingUtility = 0, newTWU = 0;
         for (auto [i, u]: transaction) {
             if (mapItem2TWU[i] >= min_util) {
-                revisedTransaction.emplace_back(i, u);
+                revisedTransaction.emplace_back(Item(i), Utility(u));
                 remainingUtility += u;
                 newTWU += u;
             }
@@ -209,6 +212,8 @@ public:
                 if (p.first == p.second)
                     continue;
                 mapFMAP.at_raw(p).atomic_insert_or_add(newTWU, MEM_ORDER_RELAXED);
+                if (top_k)
+                    mapPairUtility.at_raw(p).atomic_insert_or_add(u1 + u2, MEM_ORDER_RELAXED);
             }
         }
         co_return ret;
@@ -228,6 +233,15 @@ public:
         return nova::when_all(std::move(tasks));
     }
 
+    // search() of the root in top-k mode: its subtrees are searched one at a time (each of them in parallel) from the
+    // last candidate, of the highest TWU and with the smallest subtree, so that the threshold rises before the larger
+    // subtrees are searched whatever order the scheduler runs tasks in
+    auto searchTopK(const std::vector<UtilityList> &candidates) -> nova::task<> {
+        incCandidateCount(candidates.size());
+        for (std::size_t i = candidates.size(); i-- > 0;)
+            co_await searchX(i, std::vector<Item>{}, UtilityList{}, candidates);
+    }
+
     template<typename I>
     auto searchX(std::size_t i, const I &prefix, const UtilityList &utilityListOfP, const std::vector<UtilityList> &candidates) -> nova::task<> {
         auto &X = candidates[i];
@@ -235,11 +249,12 @@ public:
         auto p = prefix;
         p.push_back(X.item);
 
-        if (X.sumIUtils >= min_util) {
-            writeOutput(p, X.sumIUtils);
+        auto minUtil = searchMinUtil();
+        if (X.sumIUtils >= minUtil) {
+            addResult(p, X.sumIUtils);
         }
 
-        if (X.sumIUtils + X.sumRUtils >= min_util) {
+        if (extensionLength(p.size()) != 0 && X.sumIUtils + X.sumRUtils >= minUtil) {
             auto exULs = co_await make_exULs(i, utilityListOfP, candidates);
             co_await search(p, X, exULs);
         }
@@ -258,13 +273,14 @@ public:
         pxyUL.reset(py.item);
         pxyUL.reserve(px.elms.size());
         Utility totalUtility = px.sumIUtils + px.sumRUtils;
+        auto minUtil = searchMinUtil();
 
         for (auto &ex: px.elms) {
             auto ey = get_ey(ex);
             if (ey == py.elms.end() || ey->tid != ex.tid) {
                 {// LA-prune strategy
                     totalUtility -= (ex.iutil + ex.rutil);
-                    if (totalUtility < min_util)
+                    if (totalUtility < minUtil)
                         return UtilityList{};
                 }
                 continue;
@@ -288,6 +304,7 @@ public:
 
         std::vector<std::size_t> explore_j;
 
+        auto minUtil = searchMinUtil();
         for (std::size_t j = i + 1; j < ULs.size(); ++j) {
             auto &Y = ULs.at(j);
 
@@ -300,7 +317,7 @@ public:
             if (mapTWUFIt == mapFMAP.end())
                 continue;
             auto twu = mapTWUFIt->second;
-            if (twu < min_util)
+            if (twu < minUtil)
                 continue;
             explore_j.push_back(j);
         }
@@ -333,6 +350,26 @@ public:
         co_return std::move(exULs);
     }
 
+    // the search finds every single item and 2-itemset whose utility is at least the threshold, so the k-th highest
+    // of their utilities is a valid threshold. Otherwise the threshold stays low until k itemsets are found, and
+    // parallel tasks search most of the first levels with it.
+    void raiseTopKThreshold() {
+        std::vector<Utility> utils;
+        utils.reserve(listOfUtilityLists.size());
+        for (auto &ul: listOfUtilityLists)
+            utils.push_back(ul.sumIUtils);
+        for (std::size_t x = 0; x < mapPairUtility.size(); ++x) {
+            for (std::size_t y = x + 1; y < mapPairUtility.size(); ++y) {
+                if (auto u = mapPairUtility.find({x, y}))
+                    utils.push_back(u->second);
+            }
+        }
+        mapPairUtility = PairMap<Utility>();
+        top_k->raise(std::move(utils));
+        if (is_debug_mode())
+            std::cerr << "top-k threshold: " << top_k->threshold() << std::endl;
+    }
+
     template<bool do_partitioning = true>
     auto run_impl() -> nova::task<> {
         timer_start();
@@ -356,7 +393,7 @@ public:
 
         co_await calcListOfUtilityLists();
 
-        mapItem2UtilityList.resize(maxItem);
+        mapItem2UtilityList.resize(maxItem + 1);
         for (auto it = listOfUtilityLists.begin(); it < listOfUtilityLists.end(); ++it) {
             mapItem2UtilityList[it->item] = it;
         }
@@ -394,11 +431,33 @@ public:
         }
         co_await nova::when_all(std::move(tasks));
 
+        if (top_k) {
+            mapPairUtility.set_size(listOfUtilityLists.size());
+            mapPairUtility.reserve();
+            mapPairUtility.clear();
+        }
+
         co_await calcMapFMAP(database);
+        if (top_k)
+            raiseTopKThreshold();
         time_point("Build");
 
-        co_await search(std::vector<Item>{}, UtilityList{}, listOfUtilityLists);
-        time_point("Search");
+        if (top_k)
+            co_await searchTopK(listOfUtilityLists);
+        else
+            co_await search(std::vector<Item>{}, UtilityList{}, listOfUtilityLists);
+        writeTopK();
+        if (!is_sweep()) {
+            time_point("Search");
+            co_return;
+        }
+        endSweepStep();
+        // utility lists and FMAP built for min_util also hold every item and pair needed for higher thresholds
+        for (auto m: sweep_min_utils) {
+            sweep_min_util = m;
+            co_await search(std::vector<Item>{}, UtilityList{}, listOfUtilityLists);
+            endSweepStep();
+        }
     }
 
     auto run() -> nova::task<> {
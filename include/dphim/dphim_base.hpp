@@ -1,7 +1,10 @@
 #pragma once
 
+#include <dphim/binary_database.hpp>
 #include <dphim/efim.hpp>
 #include <dphim/logger.hpp>
+#include <dphim/tokenizer.hpp>
+#include <dphim/top_k.hpp>
 #include <dphim/util/parted_vec.hpp>
 #include <dphim/util/pmem_allocator.hpp>
 #include <dphim/vector_with_bytes.hpp>
@@ -9,14 +12,64 @@
 #include <nova/parallel_sort.hpp>
 #include <nova/scheduler_base.hpp>
 #include <nova/task.hpp>
+#include <nova/when_all.hpp>
 
+#include <atomic>
 #include <deque>
+#include <limits>
+#include <memory>
+#include <mutex>
 #include <sys/types.h>
 
 namespace dphim {
 
-using Transactions = PrefixSumContainer<Transaction, std::size_t, &Transaction::bytes>;
-using Database = parted_vec<Transaction, Transactions>;
+template<typename T>
+using BasicTransactions = PrefixSumContainer<T, std::size_t, &T::bytes>;
+template<typename T>
+using BasicDatabase = parted_vec<T, BasicTransactions<T>>;
+
+using Transactions = BasicTransactions<Transaction>;
+using Database = BasicDatabase<Transaction>;
+
+// TWU accumulated by every thread while transactions are parsed, and summed up once after parsing
+struct ConcurrentTWU {
+    struct Local {
+        void add(const Transaction &tra) {
+            for (auto &[item, utility]: tra) {
+                if (item >= itemTWU.size())
+                    itemTWU.resize(std::max<std::size_t>(item + 1, itemTWU.size() * 2), 0);
+                itemTWU[item] += tra.transaction_utility;
+            }
+        }
+        std::vector<Utility> itemTWU;
+    };
+
+    // the array of the current thread; valid until the calling task is suspended
+    Local &local() {
+        static thread_local std::pair<std::uint64_t, Local *> cache = {0, nullptr};
+        if (cache.first != generation) {
+            std::unique_lock lk(mtx);
+            local_list.push_back(std::make_unique<Local>());
+            cache = {generation, local_list.back().get()};
+        }
+        return *cache.second;
+    }
+
+    std::vector<Utility> get(Item max_item) {
+        std::unique_lock lk(mtx);
+        std::vector<Utility> ret(max_item + 1, 0);
+        for (auto &l: local_list)
+            for (std::size_t i = 0; i < std::min(ret.size(), l->itemTWU.size()); ++i)
+                ret[i] += l->itemTWU[i];
+        return ret;
+    }
+
+private:
+    inline static std::atomic<std::uint64_t> generation_counter = 0;
+    const std::uint64_t generation = ++generation_counter;
+    std::mutex mtx;
+    std::vector<std::unique_ptr<Local>> local_list;
+};
 
 struct DphimBase : ConcurrentLogger, pmem_allocate_trait {
 
@@ -26,6 +79,67 @@ protected:
     bool sched_no_await = false;
     PmemAllocType pmem_alloc_type = PmemAllocType::None;
 
+    // accumulate TWU while parsing instead of scanning the database again in calcTWU()
+    bool fused_twu = true;
+    std::unique_ptr<ConcurrentTWU> parsed_twu;
+
+    enum class ParserType {
+        Pread,
+        Mmap,
+        Uring,
+    } parser_type = ParserType::Mmap;
+
+    // max # of parse tasks in flight per file range (0: unbounded, see ParseQueue)
+    std::size_t parse_inflight = 256;
+
+    // top-k mode: itemsets found while searching are collected in top_k instead of the output,
+    // and the search step prunes with its threshold (see searchMinUtil())
+    std::unique_ptr<TopK> top_k;
+
+    // threshold sweep: the database built for min_util (the lowest) is searched for min_util and then for each of
+    // these thresholds in ascending order, and each search is output as its own section (see set_sweep())
+    std::vector<Utility> sweep_min_utils;
+    // minimum utility of the current search of a sweep
+    Utility sweep_min_util;
+
+    // max # of items of itemsets to search for (0: unbounded)
+    std::size_t max_length = 0;
+
+    // parse tasks of one file range, whose results are concatenated in the order of push()
+    //
+    // With max_inflight = 0, all tasks run at once and their results are concatenated at finish().
+    // Otherwise, push() first awaits the oldest tasks while `max_inflight` tasks are in flight, and appends their
+    // results to the range as soon as they are awaited. A reader that pushes tasks never runs ahead of the parsers,
+    // so raw text and per-task results of only `max_inflight` tasks are alive at the same time.
+    // The reader is moved back to `node` when it is resumed on another node after awaiting a task.
+    struct ParseQueue {
+        using Task = nova::task<std::pair<Transactions, Item>>;
+
+        ParseQueue(const DphimBase *self, int node, std::size_t max_inflight)
+            : self(self), node(node), max_inflight(max_inflight) {}
+
+        auto push(Task task) -> nova::task<>;
+
+        auto finish() -> nova::task<std::pair<Transactions, Item>>;
+
+        std::size_t task_num() const {
+            return pushed;
+        }
+
+    private:
+        using WhenAll = decltype(nova::when_all(std::vector<Task>{}));
+
+        auto pop() -> nova::task<>;
+
+        const DphimBase *self;
+        int node;
+        std::size_t max_inflight;
+        std::size_t pushed = 0;
+        std::deque<WhenAll> inflight;
+        Transactions res;
+        Item max_item = 0;
+    };
+
 public:
     void set_sched_no_await(bool flag) {
         sched_no_await = flag;
@@ -40,6 +154,82 @@ public:
         return is_debug;
     }
 
+    void set_parser_type(const std::string &typ) {
+        if (typ == "pread") {
+            parser_type = ParserType::Pread;
+        } else if (typ == "mmap") {
+            parser_type = ParserType::Mmap;
+        } else if (typ == "uring") {
+            parser_type = ParserType::Uring;
+        } else {
+            throw std::runtime_error("unknown parser type: " + typ);
+        }
+    }
+
+    void set_fused_twu(bool flag) {
+        fused_twu = flag;
+    }
+
+    void set_parse_inflight(std::size_t n) {
+        parse_inflight = n;
+    }
+
+    // search for the k itemsets with the highest utilities, starting from minutil as the threshold (0: disabled)
+    void set_top_k(std::size_t k) {
+        top_k = k ? std::make_unique<TopK>(k, min_util) : nullptr;
+    }
+
+    // search for each of `min_utils` with one Build step for the lowest of them and min_util
+    void set_sweep(std::vector<Utility> min_utils) {
+        std::sort(min_utils.begin(), min_utils.end());
+        min_utils.erase(std::unique(min_utils.begin(), min_utils.end()), min_utils.end());
+        std::erase_if(min_utils, [this](Utility m) { return m <= min_util; });
+        sweep_min_utils = std::move(min_utils);
+    }
+
+    bool is_sweep() const {
+        return !sweep_min_utils.empty();
+    }
+
+    void set_max_length(std::size_t n) {
+        max_length = n;
+    }
+
+    // max # of items that extensions of a prefix of `length` items may add
+    std::size_t extensionLength(std::size_t length) const {
+        if (max_length == 0)
+            return std::numeric_limits<std::size_t>::max();
+        return max_length - std::min(length, max_length);
+    }
+
+    // minimum utility of the search step, which is raised while searching in top-k mode
+    Utility searchMinUtil() const {
+        return top_k ? top_k->threshold() : sweep_min_util;
+    }
+
+    // close the output section and the timing ("Search@${minutil}") of the current search of a sweep
+    void endSweepStep() {
+        time_point("Search@" + std::to_string(sweep_min_util));
+        endSection(sweep_min_util);
+    }
+
+    template<typename I>
+    void addResult(const I &prefix, Utility utility) {
+        if (top_k)
+            top_k->add(prefix, utility);
+        else
+            writeOutput(prefix, utility);
+    }
+
+    // write the top-k itemsets after the search step, and report the final threshold as minUtil
+    void writeTopK() {
+        if (!top_k)
+            return;
+        for (auto &[itemset, utility]: top_k->release())
+            writeOutput(itemset, utility);
+        min_util = top_k->threshold();
+    }
+
     void set_pmem_alloc_type(const std::string &typ) {
         if (typ == "aek") {
             pmem_alloc_type = PmemAllocType::AEK;
@@ -54,7 +244,7 @@ public:
 
     DphimBase(std::shared_ptr<nova::scheduler_base> sched, std::string input_path, const std::string &output_path, Utility minutil, int th_num)
         : ConcurrentLogger(output_path, minutil, th_num),
-          sched(std::move(sched)), input_path(std::move(input_path)) {}
+          sched(std::move(sched)), input_path(std::move(input_path)), sweep_min_util(minutil) {}
 
     auto schedule(int option = -1) const -> nova::scheduler_base::operation {
         if (sched_no_await) {
@@ -64,51 +254,81 @@ public:
         }
     }
 
-    std::pair<Transaction, Item> parseOneLine(std::string line, [[maybe_unused]] int node);
+    void reserveTransaction(Transaction &tra, std::size_t n, [[maybe_unused]] int node);
+
+    std::pair<Transaction, Item> parseOneLine(std::string_view line, [[maybe_unused]] int node);
+
+    std::pair<Transaction, Item> parseOneLine(const TokenizedLines &tl, const TokenizedLine &line, const char *ed, [[maybe_unused]] int node);
+
+    // parse all lines in [bg, ed) with the block tokenizer
+    std::pair<Transactions, Item> parseTokenizedRange(const char *bg, const char *ed, int node);
 
     auto parseTransactions(std::function<std::size_t(std::size_t)> get_partition_num = nullptr)
             -> nova::task<std::pair<Database, Item>>;
 
+    // parse input files (shards) assigning each of them to one partition
+    auto parseShards(const std::vector<std::string> &paths, std::function<std::size_t(std::size_t)> get_partition_num)
+            -> nova::task<std::pair<Database, Item>>;
+
+    auto parseShard(const std::string &path, int node) -> nova::task<std::pair<Transactions, Item>>;
+
     auto parseFileRange(const char *pathname, off_t bg, off_t ed, int node) -> nova::task<std::pair<Transactions, Item>>;
 
+    auto parseMappedFileRange(const char *pathname, off_t bg, off_t ed, int node) -> nova::task<std::pair<Transactions, Item>>;
+
+    auto parseUringFileRange(const char *pathname, off_t bg, off_t ed, int node) -> nova::task<std::pair<Transactions, Item>>;
+
+    auto loadBinaryDatabase(const std::string &path, std::function<std::size_t(std::size_t)> get_partition_num = nullptr)
+            -> nova::task<std::pair<Database, Item>>;
+
+    auto loadBinaryRange(const BinaryDatabase &bin, std::size_t bg, std::size_t ed, int node) -> nova::task<Transactions>;
+
     template<typename I, typename D>
     auto calcTWU(D &database, Item max_item, std::size_t threshold = 0) -> nova::task<std::pair<std::vector<Utility>, I>> {
         if (is_debug_mode()) {
             std::cerr << "calcTWU" << std::endl;
             std::cerr << "  scatter threshold: " << threshold << std::endl;
         }
-        auto partedItemTWU = co_await partition_map(
-                database,
-                [max_item](auto &pdb, auto /*part_id*/) {
-                    std::vector<Utility> itemTWU(max_item + 1, 0);
-                    for (auto &transaction: pdb)
-                        for (auto &[item, utility]: transaction)
-                            itemTWU[item] += transaction.transaction_utility;
-                    return itemTWU;
-                },
-                [this, threshold](auto &part, auto part_id) {
-                    if (is_debug_mode()) {
-                        std::cerr << "  database@node" << part_id << ": "
-                                  << (part.get_sum_value() > threshold ? "scatter" : "no scatter")
-                                  << std::endl;
-                    }
-                    if (part.get_sum_value() > threshold) {
-                        return schedule(part_id);
-                    } else {
-                        return schedule();
-                    }
-                });
-
-        auto itemTWU = [max_item](auto &&ret) {
-            if constexpr (std::is_same_v<std::remove_cvref_t<decltype(ret)>, std::vector<Utility>>) {
-                return ret;
-            } else {
-                for (std::size_t i = 1; i < ret.size(); ++i)
-                    for (std::size_t j = 0; j < max_item + 1; ++j)
-                        ret[0][j] += ret[i][j];
-                return ret[0];
-            }
-        }(partedItemTWU);
+        std::vector<Utility> itemTWU;
+        if (parsed_twu) {
+            if (is_debug_mode())
+                std::cerr << "  use TWU accumulated while parsing" << std::endl;
+            itemTWU = parsed_twu->get(max_item);
+            parsed_twu.reset();
+        } else {
+            auto partedItemTWU = co_await partition_map(
+                    database,
+                    [max_item](auto &pdb, auto /*part_id*/) {
+                        std::vector<Utility> itemTWU(max_item + 1, 0);
+                        for (auto &transaction: pdb)
+                            for (auto &[item, utility]: transaction)
+                                itemTWU[item] += transaction.transaction_utility;
+                        return itemTWU;
+                    },
+                    [this, threshold](auto &part, auto part_id) {
+                        if (is_debug_mode()) {
+                            std::cerr << "  database@node" << part_id << ": "
+                                      << (part.get_sum_value() > threshold ? "scatter" : "no scatter")
+                                      << std::endl;
+                        }
+                        if (part.get_sum_value() > threshold) {
+                            return schedule(part_id);
+                        } else {
+                            return schedule();
+                        }
+                    });
+
+            itemTWU = [max_item](auto &&ret) {
+                if constexpr (std::is_same_v<std::remove_cvref_t<decltype(ret)>, std::vector<Utility>>) {
+                    return ret;
+                } else {
+                    for (std::size_t i = 1; i < ret.size(); ++i)
+                        for (std::size_t j = 0; j < max_item + 1; ++j)
+                            ret[0][j] += ret[i][j];
+                    return ret[0];
+                }
+            }(partedItemTWU);
+        }
 
         I items;
         items.reserve(itemTWU.size());
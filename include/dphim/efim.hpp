@@ -5,6 +5,7 @@
 
 #include <dphim/logger.hpp>
 #include <dphim/parse.hpp>
+#include <dphim/util/merge_table.hpp>
 #include <dphim/util/pmem_allocator.hpp>
 #include <dphim/util/raii.hpp>
 #include <dphim/utility_bin_array.hpp>
@@ -98,7 +99,8 @@ public:
     template<typename I>
     void run_impl();
 
-    std::pair<Transaction, Item> parseTransactionOneLine(std::string line);
+    void reserveTransaction(Transaction &tra, std::size_t n);
+    std::pair<Transaction, Item> parseTransactionOneLine(std::string_view line);
     std::pair<Database, Item> parseTransactions(const std::string &input_path);
 
     struct SearchXRet {
@@ -179,7 +181,7 @@ public:
                     ret[idx] = func(args[idx]);
                 }
             },
-                                 i * diff, std::min<int>((i + 1) * diff, args.size()));
+                                 i * diff, std::min<std::size_t>((i + 1) * diff, args.size()));
         }
         for (auto &th: threads)
             if (th.joinable())
@@ -258,6 +260,8 @@ public:
 
 public:
     bool activateTransactionMerging = true;
+    // merge projected transactions with the same extension even if they are not adjacent (see MergeTable)
+    bool useHashMerging = false;
     bool activateSubtreeUtilityPruning = true;
     long MAXIMUM_SIZE_MERGING = 1000;
     bool use_parallel_sort = true;
@@ -77,6 +77,24 @@ struct ConcurrentLogger {
         }
     }
 
+    void addFlatten(std::size_t n) {
+        if (is_debug) {
+            static thread_local auto log = flatten_log.local_value();
+            static thread_local auto f_count = flatten_count.local_value();
+            *log += n;
+            *f_count += 1;
+        }
+    }
+
+    void addReclaimed(std::size_t n) {
+        if (is_debug) {
+            static thread_local auto log = reclaim_log.local_value();
+            static thread_local auto r_count = reclaim_count.local_value();
+            *log += n;
+            *r_count += 1;
+        }
+    }
+
     template<typename I>
     void writeOutput(const I &prefix, Utility utility) {
         static thread_local auto hui = hui_count.local_value();
@@ -101,6 +119,10 @@ struct ConcurrentLogger {
     void print_json(std::ostream &out);
     void flushOutput();
 
+    // move the itemsets found so far into a section of the output for `min_util`, which also has its own counts
+    // (for threshold sweeps; call while no thread writes outputs)
+    void endSection(Utility min_util);
+
 private:
     std::fstream output;
 
@@ -114,7 +136,17 @@ private:
     ConcurrentCounter<std::size_t> candidate_count, hui_count;
     std::atomic<std::size_t> res_tid = 0;
     std::vector<std::list<std::pair<std::vector<Item>, Utility>>> results;
+    struct Section {
+        Utility min_util;
+        std::size_t hui_count, candidate_count;
+        std::list<std::pair<std::vector<Item>, Utility>> results;
+    };
+    std::vector<Section> sections;
+    // counts of itemsets for `min_util` only (not summed over the sections of a sweep)
+    std::pair<std::size_t, std::size_t> headlineCounts();
     ConcurrentCounter<std::size_t> malloc_log, malloc_count;
+    ConcurrentCounter<std::size_t> flatten_log, flatten_count;
+    ConcurrentCounter<std::size_t> reclaim_log, reclaim_count;
     TimeMeasure timer;
 };
 
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <dphim/transaction.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <span>
+#include <vector>
+
+namespace dphim {
+
+// positions of items in the transactions of one partition (a vertical view of the partition), so that
+// calcUtilityAndNextDB() visits only the transactions that contain an item, without searching for it
+struct OccurrenceIndex {
+    struct Occurrence {
+        std::uint32_t transaction;// index of the transaction in the partition
+        std::uint32_t pos;        // index of the item in the transaction
+    };
+
+    // index `items` (all <= max_item) of the transactions in `part`
+    template<typename P, typename I>
+    OccurrenceIndex(const P &part, const I &items, Item max_item) : offsets(max_item + 2, 0) {
+        std::vector<bool> indexed(max_item + 1, false);
+        for (auto item: items)
+            indexed[item] = true;
+
+        // count occurrences of each item, and then fill them (in the order of transactions)
+        for (auto &transaction: part)
+            for (auto iter = transaction.begin(); iter != transaction.end(); ++iter)
+                if (Item item = iter->first; indexed[item])
+                    ++offsets[item + 1];
+        for (std::size_t i = 1; i < offsets.size(); ++i)
+            offsets[i] += offsets[i - 1];
+        occurrences.resize(offsets.back());
+
+        auto next = offsets;
+        std::uint32_t tid = 0;
+        for (auto &transaction: part) {
+            for (auto iter = transaction.begin(); iter != transaction.end(); ++iter)
+                if (Item item = iter->first; indexed[item])
+                    occurrences[next[item]++] = {tid, static_cast<std::uint32_t>(iter - transaction.begin())};
+            ++tid;
+        }
+    }
+
+    std::span<const Occurrence> find(Item item) const {
+        if (item + 1 >= offsets.size())
+            return {};
+        return {occurrences.data() + offsets[item], occurrences.data() + offsets[item + 1]};
+    }
+
+    template<typename P>
+    static bool indexable(const P &part) {
+        return part.size() <= std::numeric_limits<std::uint32_t>::max();
+    }
+
+private:
+    std::vector<std::size_t> offsets;
+    std::vector<Occurrence> occurrences;
+};
+
+// occurrence indexes of the partitions of a database, each of which is built by the first task that asks for it
+// (tasks asking for it while it is being built get nullptr and scan the partition instead of waiting)
+struct LazyOccurrenceIndexes {
+    explicit LazyOccurrenceIndexes(std::size_t partition_num) : parts(partition_num) {}
+
+    template<typename P, typename I>
+    const OccurrenceIndex *get(std::size_t part_id, const P &part, const I &items, Item max_item) {
+        auto &p = parts[part_id];
+        auto state = p.state.load(std::memory_order_acquire);
+        if (state == State::Built)
+            return p.index.get();
+        if (state != State::None || !p.state.compare_exchange_strong(state, State::Building, std::memory_order_relaxed))
+            return nullptr;
+        p.index = std::make_unique<OccurrenceIndex>(part, items, max_item);
+        p.state.store(State::Built, std::memory_order_release);
+        return p.index.get();
+    }
+
+private:
+    enum class State {
+        None,
+        Building,
+        Built,
+    };
+
+    struct Part {
+        std::atomic<State> state = State::None;
+        std::unique_ptr<OccurrenceIndex> index;
+    };
+
+    std::vector<Part> parts;
+};
+
+}// namespace dphim
@@ -2,10 +2,86 @@
 
 #include "transaction.hpp"
 
+#include <charconv>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
 namespace dphim {
 
-std::pair<Transaction, Item> parseTransactionOneLine(std::string line);
+inline bool isDigit(char c) noexcept {
+    return static_cast<unsigned char>(c - '0') < 10;
+}
+
+// remove a comment ('%', '#' or '@') and trailing white spaces from a line
+inline std::string_view stripLine(std::string_view line) noexcept {
+    if (auto comment_pos = line.find_first_of("%#@"); comment_pos != std::string_view::npos)
+        line = line.substr(0, comment_pos);
+    while (!line.empty() && !isDigit(line.back()))
+        line.remove_suffix(1);
+    return line;
+}
+
+// Decode one line of SPMF format ("i1 i2 ...:TU:u1 u2 ...") straight into `tra`.
+// `reserve(tra, n)` is called once with the number of items, so no temporary buffer is needed.
+template<typename Reserve>
+Item decodeTransaction(std::string_view line, Transaction &tra, Reserve &&reserve) {
+    const char *p = line.data();
+    const char *const ed = line.data() + line.size();
+    auto fail = [&line]() {
+        return std::runtime_error("failed to parse: " + std::string(line));
+    };
+    auto next_number = [&p, &fail](auto &value, const char *lim) {
+        while (p < lim && !isDigit(*p))
+            ++p;
+        auto [ptr, ec] = std::from_chars(p, lim, value);
+        if (ec != std::errc{})
+            throw fail();
+        p = ptr;
+    };
+
+    const auto *colon1 = static_cast<const char *>(std::memchr(p, ':', line.size()));
+    if (!colon1)
+        throw fail();
+    std::size_t n = 0;
+    for (const char *q = p; q < colon1; ++q)
+        n += isDigit(*q) && (q == p || !isDigit(q[-1]));
+    reserve(tra, n);
+
+    Item max_item = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+        Item item;
+        next_number(item, colon1);
+        max_item = std::max(max_item, item);
+        tra.push_back(Transaction::Elem{item, 0});
+    }
 
+    p = colon1 + 1;
+    const auto *colon2 = static_cast<const char *>(std::memchr(p, ':', ed - p));
+    if (!colon2)
+        throw fail();
+    next_number(tra.transaction_utility, colon2);
+
+    p = colon2 + 1;
+    for (auto &elem: tra) {
+        Utility util;
+        next_number(util, ed);
+        elem.second = util;
+    }
+    return max_item;
+}
+
+// Input files of `input`, which is a file, a directory (all regular files in it in name order)
+// or a comma-separated list of them.
+std::vector<std::string> listInputFiles(const std::string &input);
+
+std::pair<Transaction, Item> parseTransactionOneLine(std::string_view line);
+
+// parse a database of SPMF format, or load it if it is in the binary database format
 std::pair<std::vector<Transaction>, Item> parseTransactions(const std::string &input_path);
 
-}// namespace dphim
\ No newline at end of file
+std::pair<std::vector<Transaction>, Item> loadBinaryDatabase(const std::string &input_path);
+
+}// namespace dphim
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <dphim/transaction.hpp>
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace dphim {
+
+// Result of the Build step (renamed, pruned and sorted database + name tables + SU) saved in `snapshot_dir`.
+//
+// A snapshot consists of two files: `<base>.db` in the binary database format and `<base>.meta`, where `<base>` is
+// `<prefix>.m<minutil>` (followed by `.nomerge` without merge_duplicates). The meta file is written last, so a snapshot
+// exists iff its meta file exists. A broken meta file is ignored like a missing one.
+// Snapshots are keyed by the input file (path, size and modification time), minutil and the options of the Build step
+// that change the saved database (merge_duplicates).
+struct Snapshot {
+    static constexpr char magic_value[8] = {'D', 'P', 'H', 'I', 'M', 'S', 'N', 'P'};
+    static constexpr std::uint32_t current_version = 2;
+
+    std::string input_path;// canonical path (comma-separated paths for multiple input files)
+    std::uint64_t input_size = 0;
+    std::int64_t input_mtime = 0;// ns
+    Utility min_util = 0;
+    bool merge_duplicates = true;
+
+    // indexed by new names (1..item_num()-1), index 0 is unused
+    std::vector<Item> newNameToOldNames;
+    std::vector<Utility> TWU;
+    std::vector<Utility> SU;
+
+    std::string database_path;
+
+    std::size_t item_num() const noexcept { return newNameToOldNames.size(); }
+
+    // find the snapshot of `input_path` with the largest minutil that is not greater than `min_util`
+    static std::optional<Snapshot> find(const std::string &snapshot_dir, const std::string &input_path, Utility min_util,
+                                        bool merge_duplicates);
+
+    // the snapshot of `input_path` at `min_util`; the database has to be written to `database_path` before save()
+    static Snapshot make(const std::string &snapshot_dir, const std::string &input_path, Utility min_util,
+                         bool merge_duplicates);
+
+    void save(const std::string &snapshot_dir) const;
+
+private:
+    static std::string prefix(const std::string &snapshot_dir, const std::string &canonical_path);
+    // `<prefix>.m<minutil>[.nomerge]`
+    static std::string base_path(const std::string &prefix, Utility min_util, bool merge_duplicates);
+    static std::optional<Snapshot> load(const std::string &meta_path, bool header_only);
+};
+
+}// namespace dphim
@@ -0,0 +1,113 @@
+#pragma once
+
+#include "transaction.hpp"
+
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace dphim {
+
+// Block tokenizer for the SPMF format.
+//
+// The input is classified 64 bytes at a time into bit masks of newline, colon, comment ('%', '#', '@') and
+// digit bytes (AVX2 / SSE4.2 / scalar, chosen at runtime). Only the positions where a number starts or
+// a separator appears are visited, so the cost per line is proportional to the number of fields
+// instead of the number of bytes.
+struct ByteMasks {
+    std::uint64_t newline;
+    std::uint64_t colon;
+    std::uint64_t comment;
+    std::uint64_t digit;
+};
+
+using ClassifyBlockFn = ByteMasks (*)(const char *block);
+
+// classify 64 bytes from `block`
+ClassifyBlockFn getClassifyBlock();
+ClassifyBlockFn getClassifyBlock(const std::string &isa);// "avx2", "sse4.2" or "scalar"
+const char *getClassifyBlockName(ClassifyBlockFn fn);
+
+struct TokenizedLine {
+    std::uint32_t field_bg;       // index of the first number of the line in `TokenizedLines::starts`
+    std::uint32_t before_colon1;  // # of numbers before the first ':' (= # of items)
+    std::uint32_t before_colon2;  // # of numbers before the second ':'
+    std::uint32_t field_num;      // # of numbers in the line
+    std::uint32_t colon_num;      // # of ':' in the line (at most 2 are counted)
+    std::uint32_t line_bg, line_ed;// offsets of the line (for error messages)
+};
+
+struct TokenizedLines {
+    const char *base = nullptr;
+    std::vector<std::uint32_t> starts;// offsets of the first digit of every number
+    std::vector<TokenizedLine> lines; // lines that have at least one number
+
+    std::string_view line(const TokenizedLine &l) const { return {base + l.line_bg, l.line_ed - l.line_bg}; }
+};
+
+// Tokenize [bg, ed). The range must be smaller than 4GB. Lines without numbers (e.g. comments) are skipped.
+void tokenizeLines(const char *bg, const char *ed, TokenizedLines &out, ClassifyBlockFn classify = getClassifyBlock());
+
+// Convert the number at `p` (which starts with a digit). Up to 7 digits are converted at once with SWAR;
+// longer numbers and numbers near `ed` fall back to std::from_chars.
+template<typename T>
+inline bool parseNumber(const char *p, const char *ed, T &value) {
+    if (ed - p >= 8) {
+        std::uint64_t v;
+        std::memcpy(&v, p, sizeof(v));
+        auto d = v - 0x3030303030303030ull;
+        // the high bit is set in the first byte that is not a digit (bytes after it may be broken by borrows)
+        auto non_digit = ((d + 0x7676767676767676ull) | d) & 0x8080808080808080ull;
+        if (non_digit) {
+            auto len = __builtin_ctzll(non_digit) / 8;
+            auto x = d << (64 - 8 * len);
+            x = (x * 10 + (x >> 8)) & 0x00FF00FF00FF00FFull;
+            x = (x * 100 + (x >> 16)) & 0x0000FFFF0000FFFFull;
+            x = (x * 10000 + (x >> 32)) & 0x00000000FFFFFFFFull;
+            value = static_cast<T>(x);
+            return true;
+        }
+    }
+    return std::from_chars(p, ed, value).ec == std::errc{};
+}
+
+// Decode one tokenized line into `tra` (same result as decodeTransaction() in parse.hpp).
+template<typename Reserve>
+Item decodeTokenizedTransaction(const TokenizedLines &tl, const TokenizedLine &l, const char *ed, Transaction &tra, Reserve &&reserve) {
+    auto fail = [&]() {
+        return std::runtime_error("failed to parse: " + std::string(tl.line(l)));
+    };
+    if (l.colon_num < 2 || l.before_colon2 == l.before_colon1 || l.field_num - l.before_colon2 < l.before_colon1)
+        throw fail();
+
+    const auto *starts = tl.starts.data() + l.field_bg;
+    auto number = [&](std::uint32_t i, auto &value) {
+        if (!parseNumber(tl.base + starts[i], ed, value))
+            throw fail();
+    };
+
+    std::size_t n = l.before_colon1;
+    reserve(tra, n);
+
+    Item max_item = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+        Item item;
+        number(i, item);
+        max_item = std::max(max_item, item);
+        tra.push_back(Transaction::Elem{item, 0});
+    }
+    number(l.before_colon1, tra.transaction_utility);
+    std::uint32_t i = l.before_colon2;
+    for (auto &elem: tra) {
+        Utility util;
+        number(i++, util);
+        elem.second = util;
+    }
+    return max_item;
+}
+
+}// namespace dphim
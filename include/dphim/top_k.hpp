@@ -0,0 +1,78 @@
+#pragma once
+
+#include <dphim/transaction.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace dphim {
+
+// the k itemsets with the highest utilities found so far (bounded min-heap), and the minimum utility an itemset needs to
+// be one of them, which is raised to the utility of the k-th itemset once k itemsets are found.
+// The search prunes with threshold(), a relaxed atomic load that never takes the lock, so a raised threshold reaches
+// every worker as soon as its cache line does. Only itemsets at or above the threshold take the lock, and they get
+// rarer as the threshold rises. Itemsets with the same utility as the k-th one are kept in the order they are found.
+struct TopK {
+    using Itemset = std::pair<std::vector<Item>, Utility>;
+
+    TopK(std::size_t k, Utility min_util) : k(k), min_util(min_util) {
+        heap.reserve(k);
+    }
+
+    Utility threshold() const {
+        return min_util.load(std::memory_order_relaxed);
+    }
+
+    template<typename I>
+    void add(const I &itemset, Utility utility) {
+        if (utility < threshold())
+            return;
+        std::unique_lock lk(mtx);
+        if (heap.size() == k) {
+            if (utility <= heap.front().second)
+                return;
+            std::pop_heap(heap.begin(), heap.end(), greater);
+            heap.back() = Itemset(std::vector<Item>(itemset.begin(), itemset.end()), utility);
+        } else {
+            heap.emplace_back(std::vector<Item>(itemset.begin(), itemset.end()), utility);
+        }
+        std::push_heap(heap.begin(), heap.end(), greater);
+        // only raised under the lock, so it never goes down
+        if (heap.size() == k && heap.front().second > threshold())
+            min_util.store(heap.front().second, std::memory_order_relaxed);
+    }
+
+    // raise the threshold to the k-th highest of `utilities` of distinct itemsets that the search will find
+    // (e.g. the utilities of single items), before the search finds enough itemsets to raise it
+    void raise(std::vector<Utility> utilities) {
+        if (utilities.size() < k)
+            return;
+        std::nth_element(utilities.begin(), utilities.begin() + (k - 1), utilities.end(), std::greater<>());
+        std::unique_lock lk(mtx);
+        if (utilities[k - 1] > threshold())
+            min_util.store(utilities[k - 1], std::memory_order_relaxed);
+    }
+
+    // in descending order of utility
+    std::vector<Itemset> release() {
+        std::unique_lock lk(mtx);
+        std::sort_heap(heap.begin(), heap.end(), greater);
+        return std::move(heap);
+    }
+
+private:
+    static bool greater(const Itemset &l, const Itemset &r) {
+        return l.second > r.second;
+    }
+
+    const std::size_t k;
+    std::atomic<Utility> min_util;
+    std::mutex mtx;
+    std::vector<Itemset> heap;
+};
+
+}// namespace dphim
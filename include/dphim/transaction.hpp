@@ -57,6 +57,13 @@ struct Transaction {
         return std::equal(begin(), end(), other.begin(), other.end(), [](const Elem &l, const Elem &r) { return l.first == r.first; });
     }
 
+    std::size_t hash_extension() const {
+        std::size_t h = size();
+        for (auto i = begin(); i != end(); ++i)
+            h = (h ^ i->first) * 0x100000001b3ul;
+        return h;
+    }
+
     Transaction projection(std::vector<Elem>::const_iterator iter) const {
         auto ret = *this;
         auto utilityE = iter->second;
@@ -108,21 +115,41 @@ public:
 
 #else
 
+#ifdef DPHIM_PACKED_ELEM
+// (item, utility) without the padding of std::pair (e.g. 12 bytes instead of 16 for uint32_t and uint64_t).
+// Utilities are accessed unaligned, and references to them cannot be taken (use copies or structured bindings).
+template<typename I, typename U>
+struct __attribute__((packed)) PackedElem {
+    I first;
+    U second;
+};
+static_assert(sizeof(PackedElem<Item, Utility>) == sizeof(Item) + sizeof(Utility));
+#endif
+
 struct DefaultDeleterFactory {
     auto operator()(std::size_t) const noexcept {
         return [](void *p) noexcept { std::free(p); };
     }
 };
-struct Transaction {
-    using Elem = std::pair<Item, Utility>;
-    Transaction() = default;
+
+// I and U are narrower than Item and Utility in the search phase when the dataset allows (see DPEFIM::searchNarrowest())
+template<typename I = Item, typename U = Utility>
+struct BasicTransaction {
+    using item_type = I;
+    using utility_type = U;
+#ifdef DPHIM_PACKED_ELEM
+    using Elem = PackedElem<I, U>;
+#else
+    using Elem = std::pair<I, U>;
+#endif
+    BasicTransaction() = default;
 
 private:
-    Transaction(const Transaction &) = default;
-    Transaction &operator=(const Transaction &) = default;
+    BasicTransaction(const BasicTransaction &) = default;
+    BasicTransaction &operator=(const BasicTransaction &) = default;
 
 public:
-    Transaction(Transaction &&other) noexcept
+    BasicTransaction(BasicTransaction &&other) noexcept
         : elems(std::move(other.elems)),
           elems_size(other.elems_size),
           reserved_size(other.reserved_size),
@@ -136,7 +163,7 @@ public:
         other.transaction_utility = 0;
         other.prefix_utility = 0;
     }
-    Transaction &operator=(Transaction &&other) noexcept {
+    BasicTransaction &operator=(BasicTransaction &&other) noexcept {
         if (this != &other) {
             elems = std::move(other.elems);
             elems_size = other.elems_size;
@@ -170,6 +197,17 @@ public:
     auto empty() const noexcept { return size() == 0; }
     auto bytes() const noexcept { return size() * sizeof(Elem); }
 
+    // bytes freed with this transaction: its own elements (allocated for it or in an arena released with its
+    // database), or the whole buffer it is projected from if it is its last owner; nothing for views
+    std::size_t releasable_bytes() const noexcept {
+        auto owners = elems.use_count();
+        if (owners == 0)
+            return 0;
+        if (offset == 0)
+            return bytes();
+        return owners == 1 ? reserved_size * sizeof(Elem) : 0;
+    }
+
     template<typename Cond>
     void erase_if(Cond &&cond) {
         auto new_end = std::remove_if(begin(), end(), std::forward<Cond>(cond));
@@ -206,39 +244,73 @@ public:
         elems[elems_size++] = v;
     }
 
-    [[nodiscard]] bool compare_extension(const Transaction &other) const {
+    [[nodiscard]] bool compare_extension(const BasicTransaction &other) const {
         return std::equal(begin(), end(), other.begin(), other.end(), [](const Elem &l, const Elem &r) { return l.first == r.first; });
     }
 
+    // hash of the items (transactions with the same extension have the same hash)
+    [[nodiscard]] std::size_t hash_extension() const {
+        std::size_t h = size();
+        for (auto i = begin(); i != end(); ++i)
+            h = (h ^ i->first) * 0x100000001b3ul;// FNV-1a prime
+        return h;
+    }
+
     template<typename Iter>
-    [[nodiscard]] Transaction projection(Iter iter) const {
+    [[nodiscard]] BasicTransaction projection(Iter iter) const {
         auto ret = *this;
-        auto utilityE = iter->second;
-        ret.prefix_utility += utilityE;
-        ret.transaction_utility -= utilityE;
-        for (auto i = begin(); i < iter; ++i) {
-            ret.transaction_utility -= i->second;
-        }
-        ret.offset = (iter - elems.get()) + 1;
+        ret.project(iter);
+        return ret;
+    }
+
+    // same as projection(), but the result does not share the ownership of elements (no reference counting):
+    // it is valid only while this transaction (or the owner of its elements) is alive
+    template<typename Iter>
+    [[nodiscard]] BasicTransaction projection_view(Iter iter) const {
+        BasicTransaction ret{std::shared_ptr<Elem[]>(std::shared_ptr<Elem[]>(), elems.get()),
+                             elems_size, reserved_size, offset, transaction_utility, prefix_utility};
+        ret.project(iter);
         return ret;
     }
 
-    [[nodiscard]] Transaction clone() const {
+    [[nodiscard]] BasicTransaction clone() const {
         std::shared_ptr<Elem[]> elems(new Elem[size()]);
         std::copy(begin(), end(), elems.get());
-        return Transaction{std::move(elems), size(), size(), 0, transaction_utility, prefix_utility};
+        return BasicTransaction{std::move(elems), size(), size(), 0, transaction_utility, prefix_utility};
+    }
+
+    // copy into memory allocated by `alloc_func` and owned by `owner` (e.g. an arena),
+    // so that no control block is allocated per transaction
+    template<typename A>
+    [[nodiscard]] BasicTransaction clone_into(A &&alloc_func, const std::shared_ptr<void> &owner) const {
+        auto *p = reinterpret_cast<Elem *>(alloc_func(sizeof(Elem) * size()));
+        std::uninitialized_copy(begin(), end(), p);
+        return BasicTransaction{std::shared_ptr<Elem[]>(owner, p), size(), size(), 0, transaction_utility, prefix_utility};
     }
 
     template<typename A, typename D = DefaultDeleterFactory>
-    [[nodiscard]] Transaction
+    [[nodiscard]] BasicTransaction
     clone(A &&alloc_func, D &&deleter_factory = {}) const {
         auto *p = reinterpret_cast<Elem *>(alloc_func(sizeof(Elem) * size()));
         std::shared_ptr<Elem[]> elems(p, deleter_factory(sizeof(Elem) * size()));
         std::copy(begin(), end(), elems.get());
-        return Transaction{std::move(elems), size(), size(), 0, transaction_utility, prefix_utility};
+        return BasicTransaction{std::move(elems), size(), size(), 0, transaction_utility, prefix_utility};
     }
 
-    void merge(const Transaction &other) {
+    // copy with other item/utility types (every value has to fit in them)
+    template<typename T>
+    [[nodiscard]] T convert() const {
+        using I2 = typename T::item_type;
+        using U2 = typename T::utility_type;
+        using E2 = typename T::Elem;
+        std::shared_ptr<E2[]> elems(new E2[size()]);
+        std::transform(begin(), end(), elems.get(), [](const Elem &e) {
+            return E2{static_cast<I2>(e.first), static_cast<U2>(e.second)};
+        });
+        return T{std::move(elems), size(), size(), 0, static_cast<U2>(transaction_utility), static_cast<U2>(prefix_utility)};
+    }
+
+    void merge(const BasicTransaction &other) {
         auto iter1 = begin(), iter2 = other.begin();
         for (; iter1 != end(); ++iter1, ++iter2) {
             iter1->second += iter2->second;
@@ -247,7 +319,7 @@ public:
         prefix_utility += other.prefix_utility;
     }
 
-    friend std::ostream &operator<<(std::ostream &os, const Transaction &t) {
+    friend std::ostream &operator<<(std::ostream &os, const BasicTransaction &t) {
         for (auto &&[i, u]: t) {
             os << i << "[" << u << "] ";
         }
@@ -257,8 +329,22 @@ public:
     }
 
 private:
-    Transaction(std::shared_ptr<Elem[]> &&elems, std::size_t elems_size, std::size_t reserved_size,
-                std::ptrdiff_t offset, Utility transaction_utility, Utility prefix_utility)
+    template<typename, typename>
+    friend struct BasicTransaction;
+
+    template<typename Iter>
+    void project(Iter iter) {
+        auto utilityE = iter->second;
+        prefix_utility += utilityE;
+        transaction_utility -= utilityE;
+        for (auto i = begin(); i < iter; ++i) {
+            transaction_utility -= i->second;
+        }
+        offset = (iter - elems.get()) + 1;
+    }
+
+    BasicTransaction(std::shared_ptr<Elem[]> &&elems, std::size_t elems_size, std::size_t reserved_size,
+                     std::ptrdiff_t offset, U transaction_utility, U prefix_utility)
         : elems(std::move(elems)),
           elems_size(elems_size),
           reserved_size(reserved_size),
@@ -272,10 +358,12 @@ private:
 
 public:
     std::ptrdiff_t offset = 0;
-    Utility transaction_utility = 0;
-    Utility prefix_utility = 0;
+    U transaction_utility = 0;
+    U prefix_utility = 0;
 };
 
+using Transaction = BasicTransaction<>;
+
 #endif
 
 }// namespace dphim
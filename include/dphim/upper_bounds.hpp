@@ -0,0 +1,132 @@
+#pragma once
+
+#include <dphim/transaction.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace dphim {
+
+// membership of the items to keep, indexed densely from the smallest one. Items are renamed to consecutive numbers,
+// so this takes one byte per item of the range that the utility bin array of the same search node covers.
+struct ItemMask {
+    ItemMask() = default;
+
+    // `bg`..`ed` are sorted
+    template<typename Iter>
+    ItemMask(Iter bg, Iter ed) {
+        if (bg == ed)
+            return;
+        offset = *bg;
+        mask.assign(*(ed - 1) - offset + 1, 0);
+        for (; bg != ed; ++bg)
+            mask[*bg - offset] = 1;
+    }
+
+    bool empty() const { return mask.empty(); }
+
+    bool contains(Item item) const {
+        std::size_t i = static_cast<Item>(item - offset);// wraps around below offset
+        return i < mask.size() && mask[i];
+    }
+
+private:
+    Item offset = 0;
+    std::vector<std::uint8_t> mask;
+};
+
+// the largest `n` utilities added so far, in ascending order, and their sum
+struct LargestUtilities {
+    explicit LargestUtilities(std::size_t n) : n(n) {
+        values.reserve(n);
+    }
+
+    void clear() {
+        values.clear();
+        total = 0;
+    }
+
+    void add(Utility utility) {
+        std::size_t i;
+        if (values.size() < n) {
+            values.push_back(utility);
+            total += utility;
+            for (i = values.size() - 1; i > 0 && values[i - 1] > values[i]; --i)
+                std::swap(values[i - 1], values[i]);
+        } else if (n != 0 && utility > values.front()) {
+            total += utility - values.front();
+            values.front() = utility;
+            for (i = 0; i + 1 < values.size() && values[i + 1] < values[i]; ++i)
+                std::swap(values[i], values[i + 1]);
+        }
+    }
+
+    // sum of the largest `m` (<= n) of them
+    Utility sum(std::size_t m) const {
+        Utility ret = total;
+        for (std::size_t i = 0; i + m < values.size(); ++i)
+            ret -= values[i];
+        return ret;
+    }
+
+    const std::size_t n;
+
+private:
+    std::vector<Utility> values;
+    Utility total = 0;
+};
+
+// add the local utility and the subtree utility of `transaction` to `ub` for each item of itemsToKeep (sorted) in it,
+// searching for each element of the transaction in the items before the previous one found
+template<typename UB, typename T, typename I>
+void addUpperBounds(UB &ub, const T &transaction, const I &itemsToKeep) {
+    Utility sum_remaining_utility = 0;
+    auto ed = itemsToKeep.end();
+    for (auto it = transaction.rbegin(); it != transaction.rend(); ++it) {
+        auto [item, utility] = *it;
+        auto lb = std::lower_bound(itemsToKeep.begin(), ed, Item(item));
+        if (lb != ed && *lb == item) {// contains
+            sum_remaining_utility += utility;
+            ub.getSU(item) += sum_remaining_utility + transaction.prefix_utility;
+            ub.getLU(item) += transaction.transaction_utility + transaction.prefix_utility;
+        }
+        ed = lb;
+    }
+}
+
+// same as above with the membership of itemsToKeep, which is looked up instead of searched for
+template<typename UB, typename T>
+void addUpperBounds(UB &ub, const T &transaction, const ItemMask &itemsToKeep) {
+    Utility sum_remaining_utility = 0;
+    for (auto it = transaction.rbegin(); it != transaction.rend(); ++it) {
+        auto [item, utility] = *it;
+        if (itemsToKeep.contains(item)) {
+            sum_remaining_utility += utility;
+            ub.getSU(item) += sum_remaining_utility + transaction.prefix_utility;
+            ub.getLU(item) += transaction.transaction_utility + transaction.prefix_utility;
+        }
+    }
+}
+
+// same as above for extensions of at most `largest.n` items: the subtree utility of an item counts only the
+// `largest.n - 1` largest utilities of the items to keep after it, and the local utility only the `largest.n` largest
+// ones in the transaction. With extensions of one item, the subtree utility is the utility of the extension.
+template<typename UB, typename T>
+void addUpperBounds(UB &ub, const T &transaction, const ItemMask &itemsToKeep, LargestUtilities &largest) {
+    largest.clear();
+    for (auto it = transaction.rbegin(); it != transaction.rend(); ++it) {
+        auto [item, utility] = *it;
+        if (itemsToKeep.contains(item)) {
+            ub.getSU(item) += transaction.prefix_utility + utility + largest.sum(largest.n - 1);
+            largest.add(utility);
+        }
+    }
+    Utility local_utility = transaction.prefix_utility + largest.sum(largest.n);
+    for (auto [item, utility]: transaction) {
+        if (itemsToKeep.contains(item))
+            ub.getLU(item) += local_utility;
+    }
+}
+
+}// namespace dphim
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <new>
+#include <vector>
+
+namespace dphim {
+
+// Bump allocator whose memory is released all at once when it is destructed.
+// Chunks grow geometrically from `initial_chunk_size` up to `max_chunk_size`, so that an arena of a small
+// projected database does not hold a large chunk. Objects allocated in it are not destructed.
+struct Arena {
+    using AllocFunc = std::function<void *(std::size_t)>;
+
+    static constexpr std::size_t initial_chunk_size = 1024;
+    static constexpr std::size_t max_chunk_size = 1ul << 20;
+
+    // `alloc_func` has to return memory that can be released by std::free()
+    explicit Arena(AllocFunc alloc_func = &std::malloc) : alloc_func(std::move(alloc_func)) {}
+
+    Arena(const Arena &) = delete;
+    Arena &operator=(const Arena &) = delete;
+
+    ~Arena() {
+        for (auto *p: chunks)
+            std::free(p);
+    }
+
+    void *allocate(std::size_t size, std::size_t align = alignof(std::max_align_t)) {
+        auto *p = align_up(cur, align);
+        if (cur == nullptr || p + size > end) {
+            next_chunk_size = std::min(next_chunk_size * 2, max_chunk_size);
+            new_chunk(std::max(next_chunk_size, size + align));
+            p = align_up(cur, align);
+        }
+        cur = p + size;
+        return p;
+    }
+
+    // make the following allocations of `size` bytes in total contiguous (if they need no padding for alignment)
+    void reserve(std::size_t size, std::size_t align = alignof(std::max_align_t)) {
+        if (cur == nullptr || align_up(cur, align) + size > end)
+            new_chunk(size + align);
+    }
+
+    // total size of chunks
+    std::size_t bytes() const noexcept { return reserved_bytes; }
+
+private:
+    static char *align_up(char *p, std::size_t align) {
+        return reinterpret_cast<char *>((reinterpret_cast<std::uintptr_t>(p) + align - 1) & ~(align - 1));
+    }
+
+    void new_chunk(std::size_t chunk_size) {
+        cur = static_cast<char *>(alloc_func(chunk_size));
+        if (cur == nullptr)
+            throw std::bad_alloc();
+        chunks.push_back(cur);
+        end = cur + chunk_size;
+        reserved_bytes += chunk_size;
+    }
+
+    AllocFunc alloc_func;
+    std::vector<void *> chunks;
+    char *cur = nullptr, *end = nullptr;
+    std::size_t next_chunk_size = initial_chunk_size / 2;
+    std::size_t reserved_bytes = 0;
+};
+
+}// namespace dphim
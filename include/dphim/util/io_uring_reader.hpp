@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+#include <linux/io_uring.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+namespace dphim {
+
+// Minimal io_uring wrapper (raw syscalls, no liburing) for asynchronous reads of one file.
+// submit_read() never waits, and completions are polled with poll() without entering the kernel,
+// so the caller can do other work (e.g. yield to the scheduler) while reads are in flight, and then block in wait().
+struct IoUringReader {
+    // false if io_uring is not supported by the kernel or forbidden (e.g. by seccomp)
+    static bool available();
+
+    // at most `entries` reads can be in flight
+    IoUringReader(int fd, unsigned entries);
+    IoUringReader(const IoUringReader &) = delete;
+    IoUringReader &operator=(const IoUringReader &) = delete;
+    ~IoUringReader();
+
+    // read `len` bytes at `offset` into `buf`; `user_data` is returned by poll() on completion
+    void submit_read(void *buf, std::size_t len, off_t offset, std::uint64_t user_data);
+
+    struct Completion {
+        std::uint64_t user_data;
+        int res;// bytes read, or -errno
+    };
+    std::optional<Completion> poll();
+    // block until a read completes
+    Completion wait();
+
+private:
+    void release() noexcept;
+
+    int fd;
+    int ring_fd = -1;
+
+    void *sq_ptr = nullptr, *cq_ptr = nullptr;
+    std::size_t sq_ring_size = 0, cq_ring_size = 0;
+    io_uring_sqe *sqes = nullptr;
+    std::size_t sqes_size = 0;
+
+    unsigned *sq_tail, *sq_mask, *sq_array;
+    unsigned *cq_head, *cq_tail, *cq_mask;
+    io_uring_cqe *cqes;
+
+    // iovecs of in-flight reads (IORING_OP_READV is used since it is supported by older kernels)
+    iovec *iovecs = nullptr;
+    unsigned inflight = 0;
+};
+
+}// namespace dphim
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace dphim {
+
+// Read-only mapping of [bg, end of file) of a file.
+// The mapping starts at the page boundary below `bg`, and begin() points at `bg`.
+struct MappedFile {
+    MappedFile() = default;
+
+    explicit MappedFile(const char *pathname, off_t bg = 0) {
+        int fd = open(pathname, O_RDONLY);
+        if (fd == -1)
+            throw std::runtime_error(std::string(pathname) + ": " + strerror(errno));
+
+        struct stat st;
+        if (fstat(fd, &st) == -1) {
+            close(fd);
+            throw std::runtime_error(strerror(errno));
+        }
+        file_size = st.st_size;
+        bg = std::min<off_t>(bg, file_size);
+
+        auto page_size = static_cast<off_t>(sysconf(_SC_PAGESIZE));
+        auto map_bg = bg / page_size * page_size;
+        map_size = file_size - map_bg;
+        if (map_size > 0) {
+            auto *p = mmap(nullptr, map_size, PROT_READ, MAP_PRIVATE, fd, map_bg);
+            if (p == MAP_FAILED) {
+                close(fd);
+                throw std::runtime_error(std::string("mmap: ") + strerror(errno));
+            }
+            madvise(p, map_size, MADV_SEQUENTIAL);
+            addr = static_cast<char *>(p);
+            data = addr + (bg - map_bg);
+            len = file_size - bg;
+        }
+        close(fd);
+    }
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    MappedFile(MappedFile &&other) noexcept
+        : addr(std::exchange(other.addr, nullptr)),
+          map_size(std::exchange(other.map_size, 0)),
+          data(std::exchange(other.data, nullptr)),
+          len(std::exchange(other.len, 0)),
+          file_size(std::exchange(other.file_size, 0)) {}
+
+    MappedFile &operator=(MappedFile &&other) noexcept {
+        if (this != &other) {
+            unmap();
+            addr = std::exchange(other.addr, nullptr);
+            map_size = std::exchange(other.map_size, 0);
+            data = std::exchange(other.data, nullptr);
+            len = std::exchange(other.len, 0);
+            file_size = std::exchange(other.file_size, 0);
+        }
+        return *this;
+    }
+
+    ~MappedFile() { unmap(); }
+
+    const char *begin() const noexcept { return data; }
+    const char *end() const noexcept { return data + len; }
+    std::size_t size() const noexcept { return len; }
+    bool empty() const noexcept { return len == 0; }
+    std::string_view view() const noexcept { return {data, len}; }
+    off_t get_file_size() const noexcept { return file_size; }
+
+private:
+    void unmap() noexcept {
+        if (addr)
+            munmap(addr, map_size);
+        addr = nullptr;
+    }
+
+    char *addr = nullptr;
+    std::size_t map_size = 0;
+    const char *data = nullptr;
+    std::size_t len = 0;
+    off_t file_size = 0;
+};
+
+}// namespace dphim
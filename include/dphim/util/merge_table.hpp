@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace dphim {
+
+// projected transactions indexed by their extensions (item sequences), so that each of them can be merged with the
+// one with the same extension wherever it is in the database, not only with the preceding one.
+// T has to provide hash_extension() and compare_extension(). Transactions are kept in the order they are added.
+template<typename T>
+struct MergeTable {
+    explicit MergeTable(std::size_t n = 0) {
+        heads.reserve(n);
+        transactions.reserve(n);
+        next.reserve(n);
+    }
+
+    // index of the transaction added with the same extension as `tra` (whose hash_extension() is `hash`)
+    std::optional<std::size_t> find(const T &tra, std::size_t hash) const {
+        auto it = heads.find(hash);
+        if (it == heads.end())
+            return std::nullopt;
+        for (auto i = it->second; i != npos; i = next[i])
+            if (tra.compare_extension(transactions[i]))
+                return i;
+        return std::nullopt;
+    }
+
+    void add(T &&tra, std::size_t hash) {
+        auto [it, inserted] = heads.try_emplace(hash, transactions.size());
+        if (inserted) {
+            next.push_back(npos);
+        } else {
+            next.push_back(it->second);
+            it->second = transactions.size();
+        }
+        transactions.push_back(std::move(tra));
+    }
+
+    T &operator[](std::size_t i) { return transactions[i]; }
+    const T &operator[](std::size_t i) const { return transactions[i]; }
+    std::size_t size() const noexcept { return transactions.size(); }
+
+    std::vector<T> release() {
+        heads.clear();
+        next.clear();
+        return std::move(transactions);
+    }
+
+private:
+    static constexpr std::size_t npos = ~std::size_t(0);
+
+    // hash -> the last transaction added with it; transactions with the same hash are chained by `next`
+    std::unordered_map<std::size_t, std::size_t> heads;
+    std::vector<std::size_t> next;
+    std::vector<T> transactions;
+};
+
+}// namespace dphim
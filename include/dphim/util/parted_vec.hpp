@@ -120,10 +120,11 @@ struct dynamic_array {
           len(std::exchange(other.len, 0)),
           alloc(std::move(other.alloc)) {}
 
+    // the old elements are destructed along with `other`
     dynamic_array &operator=(dynamic_array &&other) noexcept {
-        data = std::exchange(other.data, nullptr);
-        len = std::exchange(other.len, 0);
-        alloc = std::move(other.alloc);
+        std::swap(data, other.data);
+        std::swap(len, other.len);
+        std::swap(alloc, other.alloc);
         return *this;
     }
 
@@ -1,98 +1,95 @@
 #pragma once
 
 #include <dphim/transaction.hpp>
+
+#include <limits>
+#include <string>
+#include <utility>
 #include <vector>
 
 namespace dphim {
 
-#if 0
-struct UtilityBinArray {
-    UtilityBinArray() = default;
-    UtilityBinArray(std::size_t bgn, std::size_t ed, Utility d = 0)
-        : offset(bgn), LU(ed - bgn + 1, d), SU(ed - bgn + 1, d) {}
-
-private:
-    UtilityBinArray(const UtilityBinArray &) = default;
-    UtilityBinArray &operator=(const UtilityBinArray &) = default;
-
-public:
-    UtilityBinArray(UtilityBinArray &&) noexcept = default;
-    UtilityBinArray &operator=(UtilityBinArray &&) noexcept = default;
-
-    void reset(Item bgn, Item ed) {
-        offset = bgn;
-        LU.resize(ed - bgn + 1);
-        std::fill(LU.begin(), LU.end(), 0);
-        SU.resize(ed - bgn + 1);
-        std::fill(SU.begin(), SU.end(), 0);
-    }
-
-    auto size() const { return LU.size(); }
-    auto &getLU(Item i) { return LU[i - offset]; }
-    const auto &getLU(Item i) const { return LU[i - offset]; }
-    auto &getSU(Item i) { return SU[i - offset]; }
-    const auto &getSU(Item i) const { return SU[i - offset]; }
-    auto clone() const { return *this; }
-
-    UtilityBinArray &operator+=(const UtilityBinArray &other) {
-        //        if (offset != other.offset) {
-        //            throw std::runtime_error("not match offset");
-        //        } else if (LU.size() != other.LU.size()) {
-        //            throw std::runtime_error("not match LU.size()");
-        //        } else if (SU.size() != other.SU.size()) {
-        //            throw std::runtime_error("not match SU.size()");
-        //        }
-        for (auto i = 0ul; i < LU.size(); ++i) {
-            LU[i] += other.LU[i];
-        }
-        for (auto i = 0ul; i < SU.size(); ++i) {
-            SU[i] += other.SU[i];
-        }
-        return *this;
-    }
-
-private:
-    std::size_t offset = 0;
-    std::vector<Utility> LU;
-    std::vector<Utility> SU;
+// SIMD kernels of BasicUtilityBinArray (AVX-512 / AVX2 / scalar, chosen at runtime), instantiated for 32-bit and
+// 64-bit utilities in utility_bin_array.cpp
+template<typename U>
+struct UtilityBinArrayKernels {
+    // dst[i] += src[i] for i < n
+    void (*add)(U *dst, const U *src, std::size_t n);
+    // compress-store the items[i] (i < n) whose LU or SU is at least min_util into newK, and those whose SU is at
+    // least min_util into newE, where the LU and the SU of `item` are bins[2 * (item - offset)] and the next;
+    // returns the # of items of each
+    std::pair<std::size_t, std::size_t> (*select)(const Item *items, std::size_t n, Item offset, const U *bins,
+                                                  U min_util, Item *newK, Item *newE);
+    const char *name;
 };
 
-#else
+template<typename U>
+const UtilityBinArrayKernels<U> &getUtilityBinArrayKernels();
+template<typename U>
+const UtilityBinArrayKernels<U> &getUtilityBinArrayKernels(const std::string &isa);// "avx512", "avx2" or "scalar"
+
+// U is the utility type of transactions in the search phase.
+// The LU and the SU of an item are next to each other, since upper bounds are calculated by adding to both of them.
+template<typename U = Utility>
+struct BasicUtilityBinArray {
+    using utility_type = U;
 
-struct UtilityBinArray {
-    UtilityBinArray() = default;
-    UtilityBinArray(std::size_t bgn, std::size_t ed, Utility d = 0)
-        : offset(bgn), data(ed - bgn + 1, {d, d}) {}
+    BasicUtilityBinArray() = default;
+    BasicUtilityBinArray(std::size_t bgn, std::size_t ed, U d = 0)
+        : offset(bgn), bins(2 * (ed - bgn + 1), d) {}
 
-    UtilityBinArray(const UtilityBinArray &) = delete;
-    UtilityBinArray(UtilityBinArray &&) noexcept = default;
-    UtilityBinArray &operator=(const UtilityBinArray &) = delete;
-    UtilityBinArray &operator=(UtilityBinArray &&) noexcept = default;
+    BasicUtilityBinArray(const BasicUtilityBinArray &) = delete;
+    BasicUtilityBinArray(BasicUtilityBinArray &&) noexcept = default;
+    BasicUtilityBinArray &operator=(const BasicUtilityBinArray &) = delete;
+    BasicUtilityBinArray &operator=(BasicUtilityBinArray &&) noexcept = default;
 
     void reset(Item bgn, Item ed) {
         offset = bgn;
-        data.resize(ed - bgn + 1);
-        std::fill(data.begin(), data.end(), std::pair<Utility, Utility>{0, 0});
+        bins.assign(2 * (ed - bgn + 1), 0);
     }
 
-    auto size() const { return data.size(); }
-    auto &getLU(Item i) { return data[i - offset].first; }
-    const auto &getLU(Item i) const { return data[i - offset].first; }
-    auto &getSU(Item i) { return data[i - offset].second; }
-    const auto &getSU(Item i) const { return data[i - offset].second; }
+    auto size() const { return bins.size() / 2; }
+    auto &getLU(Item i) { return bins[2 * (i - offset)]; }
+    const auto &getLU(Item i) const { return bins[2 * (i - offset)]; }
+    auto &getSU(Item i) { return bins[2 * (i - offset) + 1]; }
+    const auto &getSU(Item i) const { return bins[2 * (i - offset) + 1]; }
 
-    UtilityBinArray &operator+=(const UtilityBinArray &other) {
-        for (auto i = 0ul; i < data.size(); ++i) {
-            data[i].first += other.data[i].first;
-            data[i].second += other.data[i].second;
+    BasicUtilityBinArray &operator+=(const BasicUtilityBinArray &other) {
+        getUtilityBinArrayKernels<U>().add(bins.data(), other.bins.data(), bins.size());
+        return *this;
+    }
+
+    // add `other` to this, either of which may be empty (not calculated)
+    BasicUtilityBinArray &merge(BasicUtilityBinArray &&other) {
+        if (bins.empty()) {
+            *this = std::move(other);
+        } else if (!other.bins.empty()) {
+            *this += other;
         }
         return *this;
     }
 
+    // the items of itemsToKeep[bg..] to keep (newK) and to explore (newE) after a prefix with these upper bounds
+    template<typename I>
+    void selectItems(const I &itemsToKeep, std::size_t bg, Utility min_util, I &newK, I &newE) const {
+        newK.clear();
+        newE.clear();
+        if (bg >= itemsToKeep.size() || min_util > std::numeric_limits<U>::max())
+            return;
+        auto n = itemsToKeep.size() - bg;
+        newK.resize(n);
+        newE.resize(n);
+        auto [k, e] = getUtilityBinArrayKernels<U>().select(itemsToKeep.data() + bg, n, offset, bins.data(),
+                                                              static_cast<U>(min_util), newK.data(), newE.data());
+        newK.resize(k);
+        newE.resize(e);
+    }
+
 private:
-    std::size_t offset = 0;
-    std::vector<std::pair<Utility, Utility>> data;
+    Item offset = 0;
+    std::vector<U> bins;
 };
-#endif
+
+using UtilityBinArray = BasicUtilityBinArray<>;
 
 }// namespace dphim
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <exception>
+#include <iterator>
 #include <utility>
 #include <vector>
 
@@ -201,6 +202,20 @@ struct PrefixSumContainer {
             sum_value += (storage.back().first.*GetValue)();
         }
     }
+    // moves the elements of other to the back, shifting their prefix sums instead of recalculating them
+    void append(PrefixSumContainer &&other) {
+        if (storage.empty() && storage.capacity() < other.storage.size()) {
+            *this = std::move(other);
+            other = PrefixSumContainer();
+            return;
+        }
+        auto first = storage.size();
+        storage.insert(storage.end(), std::make_move_iterator(other.storage.begin()), std::make_move_iterator(other.storage.end()));
+        for (auto i = first; i < storage.size(); ++i)
+            storage[i].second += sum_value;
+        sum_value += other.sum_value;
+        other = PrefixSumContainer();
+    }
     template<typename Pred>
     friend void erase_if(PrefixSumContainer &vec, Pred &&pred) {
         std::erase_if(vec.storage, [&pred](auto &p) { return pred(p.first); });
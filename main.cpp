@@ -1,10 +1,13 @@
 #undef NDEBUG
 
+#include <cmath>
 #include <future>
 #include <iostream>
+#include <limits>
 #include <memory>
 #include <thread>
 
+#include <dphim/binary_database.hpp>
 #include <dphim/dpefim.hpp>
 #include <dphim/dpfhm.hpp>
 #include <dphim/efim.hpp>
@@ -21,6 +24,30 @@
 #include <jemalloc/jemalloc.h>
 
 
+// comma-separated utilities, each of which may be written like 1e6, in ascending order
+std::vector<dphim::Utility> parse_minutils(const std::string &arg) {
+    std::vector<dphim::Utility> ret;
+    std::size_t bg = 0;
+    while (bg <= arg.size()) {
+        auto ed = std::min(arg.find(',', bg), arg.size());
+        auto token = arg.substr(bg, ed - bg);
+        std::size_t pos = 0;
+        long double value = -1;
+        try {
+            value = std::stold(token, &pos);
+        } catch (const std::logic_error &) {
+        }
+        // also rejects values a Utility cannot hold (negative, too large, nan) before converting
+        const auto limit = std::ldexp(1.0L, std::numeric_limits<dphim::Utility>::digits);
+        if (token.empty() || pos != token.size() || !(value >= 0 && value < limit))
+            throw std::runtime_error("invalid minutil: " + token);
+        ret.push_back(static_cast<dphim::Utility>(value));
+        bg = ed + 1;
+    }
+    std::sort(ret.begin(), ret.end());
+    return ret;
+}
+
 std::shared_ptr<nova::scheduler_base> get_scheduler(const cmdline::parser &parser) {
     auto threads = parser.get<int>("threads");
     auto sched_type = parser.get<std::string>("sched");
@@ -45,14 +72,28 @@ std::shared_ptr<nova::scheduler_base> get_scheduler(const cmdline::parser &parse
 
 int main(int argc, char *argv[]) {
 
+    if (argc >= 2 && std::string(argv[1]) == "convert") {
+        if (argc != 4) {
+            std::cerr << "usage: " << argv[0] << " convert <input (SPMF format)> <output (binary format)>" << std::endl;
+            return 1;
+        }
+        dphim::convertToBinaryDatabase(argv[2], argv[3]);
+        return 0;
+    }
+
     cmdline::parser parser;
     parser.add<std::string>("algorithm", 'a', "The kind of HUIM algorithm [efim, fhm]", false, "efim");
-    parser.add<std::string>("input", 'i', "Input file", true);
+    parser.add<std::string>("input", 'i', "Input file (or a directory / comma-separated list of shard files)", true);
     parser.add<std::string>("output", 'o', "Output path", false, "/dev/stdout");
-    parser.add<dphim::Utility>("minutil", 'm', "Minimum utility", true);
+    parser.add<std::string>("minutil", 'm', "Minimum utility, or comma-separated ones to sweep with one Build step (the initial one with --top-k)", false, "0");
+    parser.add<std::size_t>("top-k", 'k', "Search for the k itemsets with the highest utilities (0: every itemset of at least minutil)", false, 0);
+    parser.add<std::size_t>("max-length", '\0', "Search only for itemsets of at most this many items (0: unbounded)", false, 0);
     parser.add<int>("threads", 't', "# of threads", false, 1);
     parser.add<std::string>("sched", 's', "type of scheduler[global, local, local-numa, dphim, osthread, sp]", false, "local-numa");
     parser.add<std::string>("part-strategy", '\0', "Partitioning Strategy (enabled only for sp) [normal, rnd, weighted, twolen]", false, "normal");
+    parser.add<std::string>("parser", '\0', "How the input file is read [mmap, pread, uring]", false, "mmap");
+    parser.add<std::size_t>("parse-inflight", '\0', "Max # of parse tasks in flight per file range to bound memory while parsing (0: unbounded)", false, 256);
+    parser.add<std::string>("snapshot-dir", '\0', "Directory to save/reuse results of the Build step (efim only)", false, "");
 
     parser.add<int>("scatter-alloc-threshold1", '\0', "speculation threshold alpha for step3", false);
     parser.add<int>("task-migration-threshold1", '\0', "speculation threshold beta for step3", false);
@@ -66,20 +107,41 @@ int main(int argc, char *argv[]) {
     parser.add<int>("beta2", '\0', "speculation threshold beta for step3", false);
     parser.add<int>("alpha3", '\0', "speculation threshold alpha for step3", false);
     parser.add<int>("beta3", '\0', "speculation threshold beta for step3", false);
+    parser.add("adaptive-thresholds", '\0', "Adjust the step3 thresholds online starting from the given ones (efim only)");
 
     parser.add<std::string>("pmem", '\0', "which persistent memory is used: [single,numa]", false, "");
     parser.add<std::string>("pmem-alloc", '\0', "what is allocated on persistent memory: [none,elems,aek]", false, "");
 
+    parser.add("no-fused-twu", '\0', "Calculate TWU in a separate pass instead of while parsing");
+    parser.add("fused-ub", '\0', "Calculate upper bounds while projecting a large database instead of in a separate pass (efim only)");
+    parser.add<std::size_t>("flatten-max-bytes", '\0', "Copy each partition of a projected database up to this size into one buffer (efim only, 0: disabled)", false, 0);
+    parser.add<std::size_t>("flatten-min-bytes", '\0', "Min size of partitions of projected databases copied by --flatten-max-bytes (efim only)", false, 32ul << 10);
+    parser.add<std::size_t>("sequential-cutoff", '\0', "Search subtrees whose projected database bytes times # of items to explore are at most this by plain recursion (efim only, 0: disabled)", false, 64ul << 10);
+    parser.add<double>("compaction-ratio", '\0', "Copy a projected database smaller than this fraction of its parent to release the parent in single-extension chains (efim only, 0: disabled)", false, 0.25);
+    parser.add("no-merge-duplicates", '\0', "Keep identical transactions separate in the Build step (efim only)");
+    parser.add("no-item-mask", '\0', "Search for items to keep by binary search instead of a dense mask when calculating upper bounds (efim only)");
+    parser.add("no-occurrence-index", '\0', "Search every transaction for each item instead of indexing large databases (efim only)");
+    parser.add<std::size_t>("batch-siblings", '\0', "Project a database with this many sibling items by one scan (efim only)", false, 1);
+    parser.add("hash-merge", '\0', "Merge projected transactions with the same items even if they are not adjacent (efim only)");
+    parser.add("no-arena", '\0', "Allocate each merged transaction separately and reference-count projections (efim only)");
+    parser.add("no-narrow-types", '\0', "Search with 32-bit items and 64-bit utilities even if narrower ones are enough (efim only)");
     parser.add("print-pmems", '\0', "Print pmems");
     parser.add("json", '\0', "Output log in JSON format");
     parser.add("debug", '\0', "Debug mode");
 
     parser.parse_check(argc, argv);
 
+    if (!parser.exist("minutil") && !parser.exist("top-k")) {
+        std::cerr << "minutil is required unless top-k is given" << std::endl
+                  << parser.usage();
+        return 1;
+    }
+
     auto alg = parser.get<std::string>("algorithm");
     auto in = parser.get<std::string>("input");
     auto out = parser.get<std::string>("output");
-    auto minutil = parser.get<dphim::Utility>("minutil");
+    auto minutils = parse_minutils(parser.get<std::string>("minutil"));
+    auto minutil = minutils.front();
     auto threads = parser.get<int>("threads");
     auto sched_type = parser.get<std::string>("sched");
     auto pmem_type = parser.get<std::string>("pmem");
@@ -87,6 +149,11 @@ int main(int argc, char *argv[]) {
     auto json_format = parser.exist("json");
     auto debug_mode = parser.exist("debug");
     auto part_strategy = parser.get<std::string>("part-strategy");
+    auto top_k = parser.get<std::size_t>("top-k");
+    auto parser_type = parser.get<std::string>("parser");
+    if (minutils.size() > 1 && (top_k || sched_type == "sp"))
+        throw std::runtime_error("a sweep of minutils is not supported with top-k or sp");
+    auto max_length = parser.get<std::size_t>("max-length");
 
     dphim::DPEFIM::SpeculationThresholds thresholds = {};
     if (sched_type == "dphim") {
@@ -174,9 +241,12 @@ int main(int argc, char *argv[]) {
 
     if (alg == "efim") {
         if (sched_type == "sp") {
+            if (top_k || max_length)
+                throw std::runtime_error("top-k and max-length are not supported for sp");
             dphim::EFIM efim{in, out, minutil, threads};
             efim.set_debug_mode(debug_mode);
             efim.set_partition_strategy(part_strategy);
+            efim.useHashMerging = parser.exist("hash-merge");
             set_pmem(efim, pmem_type);
             efim.run();
             if (out != "/dev/null")
@@ -192,6 +262,25 @@ int main(int argc, char *argv[]) {
             dpefim.set_sched_no_await(sched_type == "para63");
             dpefim.set_speculation_thresholds(thresholds);
             dpefim.set_pmem_alloc_type(pmem_alloc_type);
+            dpefim.set_parser_type(parser_type);
+            dpefim.set_fused_twu(!parser.exist("no-fused-twu"));
+            dpefim.set_parse_inflight(parser.get<std::size_t>("parse-inflight"));
+            dpefim.set_snapshot_dir(parser.get<std::string>("snapshot-dir"));
+            dpefim.set_narrow_types(!parser.exist("no-narrow-types"));
+            dpefim.set_use_arena(!parser.exist("no-arena"));
+            dpefim.set_hash_merge(parser.exist("hash-merge"));
+            dpefim.set_batch_siblings(parser.get<std::size_t>("batch-siblings"));
+            dpefim.set_fused_upper_bounds(parser.exist("fused-ub"));
+            dpefim.set_use_occurrence_index(!parser.exist("no-occurrence-index"));
+            dpefim.set_use_item_mask(!parser.exist("no-item-mask"));
+            dpefim.set_adaptive_thresholds(parser.exist("adaptive-thresholds"));
+            dpefim.set_merge_duplicates(!parser.exist("no-merge-duplicates"));
+            dpefim.set_flatten_bytes(parser.get<std::size_t>("flatten-min-bytes"), parser.get<std::size_t>("flatten-max-bytes"));
+            dpefim.set_compaction_ratio(parser.get<double>("compaction-ratio"));
+            dpefim.set_sequential_cutoff(parser.get<std::size_t>("sequential-cutoff"));
+            dpefim.set_top_k(top_k);
+            dpefim.set_sweep(minutils);
+            dpefim.set_max_length(max_length);
             set_pmem(dpefim, pmem_type);
             exec_dp(dpefim, sched);
         }
@@ -204,6 +293,12 @@ int main(int argc, char *argv[]) {
                 dpfhm.set_sched_no_await(true);
             set_pmem(dpfhm, pmem_type);
             dpfhm.set_pmem_alloc_type(pmem_alloc_type);
+            dpfhm.set_parser_type(parser_type);
+            dpfhm.set_fused_twu(!parser.exist("no-fused-twu"));
+            dpfhm.set_parse_inflight(parser.get<std::size_t>("parse-inflight"));
+            dpfhm.set_top_k(top_k);
+            dpfhm.set_sweep(minutils);
+            dpfhm.set_max_length(max_length);
             exec_dp(dpfhm, sched);
         }
     } else {
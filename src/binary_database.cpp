@@ -0,0 +1,71 @@
+#include <dphim/binary_database.hpp>
+#include <dphim/parse.hpp>
+
+#include <fstream>
+#include <limits>
+
+namespace dphim {
+
+namespace {
+
+// `num` elements of T at `pos` of `file`
+template<typename T>
+const T *sectionAt(const MappedFile &file, std::uint64_t pos, std::uint64_t num, const std::string &error) {
+    if (pos < sizeof(BinaryDatabaseHeader) || pos > file.size() || pos % alignof(T) != 0 ||
+        num > (file.size() - pos) / sizeof(T))
+        throw std::runtime_error(error);
+    return reinterpret_cast<const T *>(file.begin() + pos);
+}
+
+}// namespace
+
+bool isBinaryDatabase(const std::string &path) {
+    std::ifstream in(path, std::ios::in | std::ios::binary);
+    char magic[sizeof(BinaryDatabaseHeader::magic_value)] = {};
+    in.read(magic, sizeof(magic));
+    return in && std::memcmp(magic, BinaryDatabaseHeader::magic_value, sizeof(magic)) == 0;
+}
+
+BinaryDatabase::BinaryDatabase(const std::string &path)
+    : file(path.c_str()) {
+    if (file.size() < sizeof(BinaryDatabaseHeader))
+        throw std::runtime_error(path + ": too small for a binary database");
+
+    header = reinterpret_cast<const BinaryDatabaseHeader *>(file.begin());
+    if (std::memcmp(header->magic, BinaryDatabaseHeader::magic_value, sizeof(header->magic)) != 0)
+        throw std::runtime_error(path + ": not a binary database");
+    if (header->version != BinaryDatabaseHeader::current_version)
+        throw std::runtime_error(path + ": unsupported binary database version " + std::to_string(header->version));
+    if (header->item_bytes != sizeof(Item) || header->utility_bytes != sizeof(Utility))
+        throw std::runtime_error(path + ": item/utility width mismatch");
+    if (header->file_size != file.size())
+        throw std::runtime_error(path + ": truncated binary database");
+
+    if (header->transaction_num == std::numeric_limits<std::uint64_t>::max())
+        throw std::runtime_error(path + ": invalid number of transactions");
+    if (header->max_item > std::numeric_limits<Item>::max())
+        throw std::runtime_error(path + ": max item out of range");
+
+    // the header is not trusted: every section must lie after the header in the file, aligned for its elements
+    offsets = sectionAt<std::uint64_t>(file, header->offsets_pos, header->transaction_num + 1, path + ": invalid offsets section");
+    items = sectionAt<Item>(file, header->items_pos, header->elem_num, path + ": invalid items section");
+    utilities = sectionAt<Utility>(file, header->utilities_pos, header->elem_num, path + ": invalid utilities section");
+    transaction_utilities = sectionAt<Utility>(file, header->transaction_utilities_pos, header->transaction_num,
+                                               path + ": invalid transaction utilities section");
+
+    if (offsets[0] != 0 || offsets[header->transaction_num] != header->elem_num)
+        throw std::runtime_error(path + ": invalid offsets");
+    for (std::uint64_t i = 0; i < header->transaction_num; ++i)
+        if (offsets[i] > offsets[i + 1])
+            throw std::runtime_error(path + ": decreasing offsets");
+    for (std::uint64_t k = 0; k < header->elem_num; ++k)
+        if (items[k] > header->max_item)
+            throw std::runtime_error(path + ": item " + std::to_string(items[k]) + " exceeds max item");
+}
+
+void convertToBinaryDatabase(const std::string &input_path, const std::string &output_path) {
+    auto [transactions, max_item] = parseTransactions(input_path);
+    writeBinaryDatabase(output_path, transactions, max_item);
+}
+
+}// namespace dphim
@@ -1,5 +1,6 @@
 #include <dphim/dpefim.hpp>
 #include <dphim/parse.hpp>
+#include <dphim/snapshot.hpp>
 
 #include <nova/jemalloc.hpp>
 #include <nova/numa_aware_scheduler.hpp>
@@ -26,7 +27,7 @@ auto DPEFIM::run_impl() -> nova::task<> {
 
     timer_start();
 
-    auto [database, mI] = co_await parseTransactions([this](std::size_t fsize) {
+    auto get_partition_num = [this](std::size_t fsize) {
         auto ret = fsize > this->thresholds.step1_scatter_alloc_threshold
                            ? sched->get_max_node_id().value_or(0) + 1
                            : 1;
@@ -36,7 +37,23 @@ auto DPEFIM::run_impl() -> nova::task<> {
             std::cerr << "  partition num: " << ret << std::endl;
         }
         return ret;
-    });
+    };
+
+    // a snapshot taken at minutil <= min_util contains every transaction and item needed for min_util
+    std::optional<Snapshot> snapshot;
+    if (!snapshot_dir.empty())
+        snapshot = Snapshot::find(snapshot_dir, input_path, min_util, merge_duplicates);
+    bool exact_snapshot = snapshot && snapshot->min_util == min_util;
+    if (is_debug_mode()) {
+        if (snapshot)
+            std::cerr << "use snapshot: " << snapshot->database_path << " (minutil=" << snapshot->min_util << ")" << std::endl;
+        else if (!snapshot_dir.empty())
+            std::cerr << "no snapshot in " << snapshot_dir << std::endl;
+    }
+
+    auto load = snapshot ? loadBinaryDatabase(snapshot->database_path, get_partition_num)
+                         : parseTransactions(get_partition_num);
+    auto [database, mI] = co_await std::move(load);
     partition_num = database.partition_num();
     maxItem = mI;
 
@@ -48,7 +65,17 @@ auto DPEFIM::run_impl() -> nova::task<> {
         std::cerr << "  maxItem: " << maxItem << std::endl;
     }
 
-    auto [LU, itemsToKeep] = co_await calcTWU<I>(database, maxItem);
+    std::vector<Utility> LU;
+    I itemsToKeep;
+    if (snapshot) {
+        // items of the snapshot are already sorted in ascending order of TWU
+        LU = snapshot->TWU;
+        for (Item item = 1; item < snapshot->item_num(); ++item)
+            if (LU[item] >= min_util)
+                itemsToKeep.push_back(item);
+    } else {
+        std::tie(LU, itemsToKeep) = co_await calcTWU<I>(database, maxItem);
+    }
     time_point("calcTWU");
     if (is_debug_mode()) {
         std::cerr << " # of itemsToKeep: " << itemsToKeep.size() << std::endl;
@@ -59,80 +86,140 @@ auto DPEFIM::run_impl() -> nova::task<> {
         }
     }
 
-    // set new name
-    oldNameToNewNames.resize(maxItem + 1, 0);
-    newNameToOldNames.resize(maxItem + 1, 0);
-    Item currentName = 1;
-    for (auto &item: itemsToKeep) {
-        oldNameToNewNames[item] = currentName;
-        newNameToOldNames[currentName] = item;
-        item = currentName;
-        currentName++;
-    }
-    maxItem = currentName;
-
+    std::vector<Utility> SU, TWU;
+    if (exact_snapshot) {
+        // the snapshot is exactly the result of the following steps
+        newNameToOldNames = std::move(snapshot->newNameToOldNames);
+        maxItem = newNameToOldNames.size();
+        SU = std::move(snapshot->SU);
+    } else {
+        // set new name
+        oldNameToNewNames.resize(maxItem + 1, 0);
+        newNameToOldNames.resize(maxItem + 1, 0);
+        TWU.resize(maxItem + 1, 0);
+        Item currentName = 1;
+        for (auto &item: itemsToKeep) {
+            oldNameToNewNames[item] = currentName;
+            newNameToOldNames[currentName] = snapshot ? snapshot->newNameToOldNames[item] : item;
+            TWU[currentName] = LU[item];
+            item = currentName;
+            currentName++;
+        }
+        maxItem = currentName;
+        newNameToOldNames.resize(maxItem);
+        TWU.resize(maxItem);
+
+
+        // remove unpromising elems and rename elems from old names to new names
+        co_await for_each_batched(
+                database,
+                [this](Transaction &transaction, auto /*part_id*/) {
+                    for (auto &[item, util]: transaction)
+                        item = oldNameToNewNames[item];
+                    transaction.erase_if([&](const auto &p) { return p.first == 0; });// remove invalid name
+                    std::sort(transaction.begin(), transaction.end(),
+                              [&](const auto &l, const auto &r) { return l.first < r.first; });
+                },
+                [this](auto node_id, auto bg, auto ed) {
+                    auto range = PrefixSumRange(bg, ed);
+                    if (range.get_sum_value() > thresholds.step2_task_migration_threshold) {
+                        return schedule(node_id);
+                    } else {
+                        return schedule();
+                    }
+                },
+                500);
 
-    // remove unpromising elems and rename elems from old names to new names
-    co_await for_each_batched(
-            database,
-            [this](Transaction &transaction, auto /*part_id*/) {
-                for (auto &[item, util]: transaction)
-                    item = oldNameToNewNames[item];
-                transaction.erase_if([&](const auto &p) { return p.first == 0; });// remove invalid name
-                std::sort(transaction.begin(), transaction.end(),
-                          [&](const auto &l, const auto &r) { return l.first < r.first; });
-            },
-            [this](auto node_id, auto bg, auto ed) {
-                auto range = PrefixSumRange(bg, ed);
-                if (range.get_sum_value() > thresholds.step2_task_migration_threshold) {
-                    return schedule(node_id);
-                } else {
-                    return schedule();
-                }
-            },
-            500);
+        using std::erase_if;
+        auto pre_size = database.size();
+        erase_if(database, [](const Transaction &t) { return t.empty(); });
+        if (is_debug_mode()) {
+            std::cerr << "remove item with TWU under minutil" << std::endl;
+            std::cerr << "  # of transactions: " << pre_size << " -> " << database.size() << std::endl;
+        }
 
-    using std::erase_if;
-    auto pre_size = database.size();
-    erase_if(database, [](const Transaction &t) { return t.empty(); });
-    if (is_debug_mode()) {
-        std::cerr << "remove item with TWU under minutil" << std::endl;
-        std::cerr << "  # of transactions: " << pre_size << " -> " << database.size() << std::endl;
-    }
+        auto comp = [](auto &l, auto &r) {
+            return std::lexicographical_compare(
+                    r.rbegin(), r.rend(), l.rbegin(), l.rend(), [](auto &l, auto &r) { return l.first < r.first; });
+        };
 
-    auto comp = [](auto &l, auto &r) {
-        return std::lexicographical_compare(
-                r.rbegin(), r.rend(), l.rbegin(), l.rend(), [](auto &l, auto &r) { return l.first < r.first; });
-    };
+        if (is_debug_mode()) {
+            std::cerr << "sort transactions" << std::endl;
+            std::cerr << "  " << (use_parallel_sort ? "parallel sort" : "simple sort") << std::endl;
+        }
 
-    if (is_debug_mode()) {
-        std::cerr << "sort transactions" << std::endl;
-        std::cerr << "  " << (use_parallel_sort ? "parallel sort" : "simple sort") << std::endl;
-    }
+        if (use_parallel_sort) {
+            std::vector<nova::task<>> tasks;
+            for (std::size_t i = 0; i < database.partitions().size(); ++i) {
+                auto &part = database.get(i);
+                tasks.push_back(nova::parallel_sort(
+                        part.begin(), part.end(), comp, [](auto self, auto node) { return self->schedule(node); }, this, i));
+            }
+            co_await nova::when_all(std::move(tasks));
+        } else {
+            std::sort(database.begin(), database.end(), comp);
+        }
 
-    if (use_parallel_sort) {
-        std::vector<nova::task<>> tasks;
         for (std::size_t i = 0; i < database.partitions().size(); ++i) {
             auto &part = database.get(i);
-            tasks.push_back(nova::parallel_sort(
-                    part.begin(), part.end(), comp, [](auto self, auto node) { return self->schedule(node); }, this, i));
+            part.recalc();
         }
-        co_await nova::when_all(std::move(tasks));
-    } else {
-        std::sort(database.begin(), database.end(), comp);
-    }
 
-    for (std::size_t i = 0; i < database.partitions().size(); ++i) {
-        auto &part = database.get(i);
-        part.recalc();
+        if (merge_duplicates) {
+            // identical transactions are adjacent after sorting
+            std::size_t removed = 0;
+            for (auto n: co_await partition_map(
+                         database,
+                         [](Transactions &part, auto /*part_id*/) -> std::size_t {
+                             if (part.empty())
+                                 return 0;
+                             auto last = part.begin();
+                             for (auto iter = last + 1; iter != part.end(); ++iter) {
+                                 if (iter->compare_extension(*last)) {
+                                     last->merge(*iter);
+                                 } else if (++last != iter) {
+                                     *last = std::move(*iter);
+                                 }
+                             }
+                             auto pre_size = part.size();
+                             part.erase(last + 1, part.end());
+                             return pre_size - part.size();
+                         },
+                         [this](Transactions &part, std::size_t node) {
+                             if (part.get_sum_value() > thresholds.step2_task_migration_threshold) {
+                                 return schedule(static_cast<int>(node));
+                             } else {
+                                 return schedule();
+                             }
+                         }))
+                removed += n;
+            if (is_debug_mode()) {
+                std::cerr << "merge identical transactions" << std::endl;
+                std::cerr << "  # of transactions: " << database.size() + removed << " -> " << database.size() << std::endl;
+            }
+        }
+        SU = co_await calcFirstSU(database);
     }
-    auto SU = co_await calcFirstSU(database);
 
     I itemsToExplore;
     for (auto item: itemsToKeep)
         if (SU[item] >= min_util)
             itemsToExplore.emplace_back(item);
     time_point("Build");
+    if (is_sweep())
+        firstSU = SU;
+
+    if (!snapshot_dir.empty() && !exact_snapshot) {
+        auto snap = Snapshot::make(snapshot_dir, input_path, min_util, merge_duplicates);
+        snap.newNameToOldNames = newNameToOldNames;
+        snap.TWU = std::move(TWU);
+        snap.SU = SU;
+        writeBinaryDatabase(snap.database_path, database, maxItem - 1);
+        snap.save(snapshot_dir);
+        time_point("saveSnapshot");
+        if (is_debug_mode())
+            std::cerr << "save snapshot: " << snap.database_path << std::endl;
+    }
 
     if (is_debug_mode()) {
         std::cerr << "  # of itemsToExplore: " << itemsToExplore.size() << std::endl;
@@ -153,9 +240,106 @@ auto DPEFIM::run_impl() -> nova::task<> {
         std::cerr << "  stop_task_migration_depth: " << thresholds.step3_stop_task_migration_depth << std::endl;
     }
 
+    if (use_adaptive_thresholds)
+        adaptive_thresholds = std::make_unique<AdaptiveThresholds>(
+                thresholds.step3_task_migration_threshold, thresholds.step3_scatter_alloc_threshold, partition_num);
+
     sched_no_await = false;
-    co_await search({}, std::move(database), std::move(itemsToKeep), std::move(itemsToExplore));
-    time_point("Search");
+    co_await searchNarrowest(std::move(database), std::move(itemsToKeep), std::move(itemsToExplore));
+    writeTopK();
+    if (!is_sweep())
+        time_point("Search");
+
+    if (adaptive_thresholds && is_debug_mode())
+        adaptive_thresholds->print(std::cerr);
+}
+
+template<typename I>
+auto DPEFIM::searchNarrowest(Database database, I itemsToKeep, I itemsToExplore) -> nova::task<> {
+    // every utility in the search phase (projected/merged transactions and upper bounds) is bounded by
+    // the sum of transaction utilities, and items are renamed to 1..maxItem-1
+    Utility total_utility = 0;
+    for (const auto &transaction: database)
+        total_utility += transaction.transaction_utility + transaction.prefix_utility;
+    bool narrow_item = maxItem - 1 <= std::numeric_limits<std::uint16_t>::max();
+    bool narrow_utility = total_utility <= std::numeric_limits<std::uint32_t>::max();
+
+    // items are narrowed only when it makes elements smaller (e.g. pair<uint16_t, uint32_t> is as large as pair<uint32_t, uint32_t>)
+    constexpr bool narrow_item_u32 = sizeof(BasicTransaction<std::uint16_t, std::uint32_t>::Elem) < sizeof(BasicTransaction<Item, std::uint32_t>::Elem);
+    constexpr bool narrow_item_u64 = sizeof(BasicTransaction<std::uint16_t, Utility>::Elem) < sizeof(BasicTransaction<Item, Utility>::Elem);
+
+    if (is_debug_mode()) {
+        std::cerr << "narrow types: " << (narrow_types ? "enabled" : "disabled") << std::endl;
+        std::cerr << "  max item: " << maxItem - 1 << ", total utility: " << total_utility << std::endl;
+    }
+
+    // transactions allocated by pmem allocators are kept as they are
+    if (!narrow_types || pmem_alloc_type != PmemAllocType::None) {
+        co_await searchRoot(database, std::move(itemsToKeep), std::move(itemsToExplore));
+    } else if (narrow_utility) {
+        if (narrow_item_u32 && narrow_item)
+            co_await searchAs<BasicTransaction<std::uint16_t, std::uint32_t>>(std::move(database), std::move(itemsToKeep), std::move(itemsToExplore));
+        else
+            co_await searchAs<BasicTransaction<Item, std::uint32_t>>(std::move(database), std::move(itemsToKeep), std::move(itemsToExplore));
+    } else if (narrow_item_u64 && narrow_item) {
+        co_await searchAs<BasicTransaction<std::uint16_t, Utility>>(std::move(database), std::move(itemsToKeep), std::move(itemsToExplore));
+    } else {
+        co_await searchRoot(database, std::move(itemsToKeep), std::move(itemsToExplore));
+    }
+}
+
+template<typename T, typename I>
+auto DPEFIM::searchAs(Database database, I itemsToKeep, I itemsToExplore) -> nova::task<> {
+    if (is_debug_mode()) {
+        std::cerr << "search with " << sizeof(typename T::item_type) * 8 << "-bit items and "
+                  << sizeof(typename T::utility_type) * 8 << "-bit utilities" << std::endl;
+    }
+
+    // convert on the node of each partition, releasing the original transactions one by one
+    BasicDatabase<T> converted(database.partition_num());
+    std::size_t i = 0;
+    for (auto &&part: co_await partition_map(
+                 database,
+                 [](Transactions &part, auto /*part_id*/) -> BasicTransactions<T> {
+                     BasicTransactions<T> ret;
+                     ret.reserve(part.size());
+                     for (auto &transaction: part) {
+                         ret.push_back(transaction.template convert<T>());
+                         transaction = Transaction{};
+                     }
+                     part = Transactions{};
+                     return ret;
+                 },
+                 [this]([[maybe_unused]] auto &part, std::size_t node) {
+                     return schedule(static_cast<int>(node));
+                 })) {
+        converted.get(i++) = std::move(part);
+    }
+    time_point("narrowTypes");
+
+    co_await searchRoot(converted, std::move(itemsToKeep), std::move(itemsToExplore));
+}
+
+template<typename D, typename I>
+auto DPEFIM::searchRoot(const D &database, I itemsToKeep, I itemsToExplore) -> nova::task<> {
+    if (!is_sweep()) {
+        co_await search({}, database, std::move(itemsToKeep), std::move(itemsToExplore));
+        co_return;
+    }
+    co_await search({}, database, I(itemsToKeep), I(itemsToExplore));
+    endSweepStep();
+    // the database and the items to keep for min_util are a superset of the ones for higher thresholds, whose extra
+    // items are pruned by the upper bounds of the first projections; only the items to explore are narrowed here
+    for (auto m: sweep_min_utils) {
+        sweep_min_util = m;
+        I explore;
+        for (auto item: itemsToExplore)
+            if (firstSU[item] >= m)
+                explore.push_back(item);
+        if (!explore.empty())
+            co_await search({}, database, I(itemsToKeep), std::move(explore));
+        endSweepStep();
+    }
 }
 
 auto DPEFIM::run() -> nova::task<> {
@@ -206,168 +390,418 @@ auto DPEFIM::calcFirstSU(D &database) -> nova::task<std::vector<Utility>> {
 }
 
 template<typename D, typename I, typename I2>
-auto DPEFIM::searchX(int j, I &&prefix, const D &transactionsOfP, I2 &&itemsToKeep, I2 &&itemsToExplore) -> nova::task<> {
+auto DPEFIM::searchX(int j, I &&prefix, D &&transactionsOfP, I2 &&itemsToKeep, I2 &&itemsToExplore,
+                     std::shared_ptr<LazyOccurrenceIndexes> index,
+                     std::optional<Projection<typename std::remove_cvref_t<D>::value_type>> projected) -> nova::task<> {
+    using DB = std::remove_cvref_t<D>;
 
-    if (itemsToExplore.size() > 1)
+    if (itemsToExplore.size() > 1 && shouldSpawn(sumBytes(transactionsOfP))) {
+        auto spawner = std::this_thread::get_id();
         co_await schedule();
+        addSpawn(spawner);
+    }
 
     auto x = itemsToExplore[j];
     auto depth = prefix.size();
+    auto extension = extensionLength(depth + 1);
+
+    // calculated while projecting if fused (see fused_upper_bounds), which does not bound the length of extensions
+    std::span<const Item> keep;
+    if (fused_upper_bounds && max_length == 0 && !projected && sumBytes(transactionsOfP) >= fused_upper_bounds_min_bytes)
+        keep = std::span<const Item>(itemsToKeep.data(), itemsToKeep.size());
 
     Utility utilityPx = 0;
-    D transactionPx(transactionsOfP.partition_num());
+    DB transactionPx(transactionsOfP.partition_num());
+    BasicUtilityBinArray<typename DB::value_type::utility_type> ub;
 
-    for (auto &&[util, db]:
-         co_await partition_map(
-                 transactionsOfP,
-                 [this, depth, x](auto &db, auto node) {
-                     return calcUtilityAndNextDB(x, db, node, depth < thresholds.step3_stop_task_migration_depth);
-                 },
-                 [this]([[maybe_unused]] auto &part, std::size_t node) {
-                     return schedule(static_cast<int>(node));
-                 },
-                 [this, depth](auto &part, auto /*id*/) {
-                     return depth < thresholds.step3_stop_task_migration_depth &&
-                            part.get_sum_value() > thresholds.step3_task_migration_threshold;
-                 })) {
-        utilityPx += util;
-        transactionPx.merge(std::move(db));
+    if (projected) {
+        std::tie(utilityPx, transactionPx, ub) = std::move(*projected);
+        projected.reset();
+    } else {
+        for (auto &&[util, db, part_ub]:
+             co_await partition_map(
+                     transactionsOfP,
+                     [this, depth, x, j, keep, &index, &itemsToExplore](auto &db, auto node) {
+                         const OccurrenceIndex *occ = nullptr;
+                         if (index && db.get_sum_value() >= occurrence_index_min_bytes && OccurrenceIndex::indexable(db))
+                             occ = index->get(node, db, itemsToExplore, maxItem);
+                         return timeScan(db, node, [&] {
+                             return calcUtilityAndNextDB(x, db, node, depth < thresholds.step3_stop_task_migration_depth, occ, keep, j);
+                         });
+                     },
+                     [this]([[maybe_unused]] auto &part, std::size_t node) {
+                         return schedule(static_cast<int>(node));
+                     },
+                     [this, depth](auto &part, auto /*id*/) {
+                         return shouldMigrate(depth, part.get_sum_value());
+                     })) {
+            utilityPx += util;
+            transactionPx.merge(std::move(db));
+            ub.merge(std::move(part_ub));
+        }
     }
 
-    auto makeNewItems = [j, min_util = min_util](auto &&ub, auto &&K) {
-        std::remove_cvref_t<I2> newK, newE;
-        newK.reserve(K.size() - j + 1);
-        newE.reserve(K.size() - j + 1);
-        for (int i = j + 1; i < int(K.size()); ++i) {
-            auto item = K[i];
-            if (ub.getSU(item) >= min_util) {
-                newK.emplace_back(item);
-                newE.emplace_back(item);
-            } else if (ub.getLU(item) >= min_util) {
-                newK.emplace_back(item);
-            }
-        }
-        return std::make_tuple(std::move(newK), std::move(newE));
-    };
+    // nobody else searches transactionsOfP (see below), so it can be released before searching transactionPx
+    // unless transactionPx still has views of its buffers
+    bool compact = false;
+    if constexpr (!std::is_lvalue_reference_v<D>)
+        compact = shouldCompact(transactionPx, transactionsOfP);
 
-    UtilityBinArray ub;
-    for (std::size_t nid = 0; nid < transactionPx.partition_num(); ++nid) {
+    bool fused = ub.size() != 0;
+    auto mask = fused ? ItemMask() : makeItemMask(j, itemsToKeep);
+    for (std::size_t nid = 0; extension != 0 && nid < transactionPx.partition_num(); ++nid) {
         auto &db = transactionPx.get(nid);
-        if (depth < thresholds.step3_stop_task_migration_depth &&
-            db.get_sum_value() > thresholds.step3_task_migration_threshold)
+        // the partition is scanned by calcUtilityAndNextDB() of every child (and by calcUpperBoundsImpl() if not fused)
+        bool flatten = compact || (static_cast<std::size_t>(j) + 2 < itemsToKeep.size() && shouldFlatten(db));
+        if (fused && !flatten)
+            continue;
+        if (shouldMigrate(depth, db.get_sum_value())) {
+            auto migration_bg = AdaptiveThresholds::clock::now();
             co_await schedule(nid);
-        calcUpperBoundsImpl(ub, j, db, itemsToKeep);
+            addMigration(AdaptiveThresholds::clock::now() - migration_bg);
+        }
+        if (flatten) {
+            flattenTransactions(db, transactionPx.partition_num() > 1 ? std::optional<int>(nid) : std::nullopt);
+            if (!compact)
+                addFlatten(db.get_sum_value());
+        }
+        if (!fused)
+            calcUpperBoundsImpl(ub, j, db, itemsToKeep, mask, extension);
     }
 
+    if constexpr (!std::is_lvalue_reference_v<D>) {
+        // views into the buffers of ancestors are not freed with transactionsOfP
+        if (compact)
+            addReclaimed(std::max(releasableBytes(transactionsOfP), sumBytes(transactionPx)) - sumBytes(transactionPx));
+        // projections share the ownership of the buffers unless they are views
+        if (compact || !use_arena || pmem_alloc_type != PmemAllocType::None)
+            transactionsOfP = DB(transactionsOfP.partition_num());
+    }
+
+    auto minUtil = searchMinUtil();
     std::remove_cvref_t<I2> newK, newE;
-    std::tie(newK, newE) = makeNewItems(ub, itemsToKeep);
+    if (extension != 0)
+        ub.selectItems(itemsToKeep, j + 1, minUtil, newK, newE);
 
-    if (utilityPx >= min_util || !newE.empty()) {
+    if (utilityPx >= minUtil || !newE.empty()) {
         auto p = prefix;
         p.push_back(newNameToOldNames[x]);
-        if (utilityPx >= min_util) {
-            writeOutput(p, utilityPx);
+        if (utilityPx >= minUtil) {
+            addResult(p, utilityPx);
         }
-        if (newE.size() == 1) {
+        if (extension == 1) {
+            addLastExtensions(p, ub, newE);
+        } else if (!newE.empty() && shouldSearchSequentially(transactionPx, newE)) {
+            searchSequential(p, transactionPx, newK, newE);
+        } else if (newE.size() == 1) {
             incCandidateCount(1);
-            co_await searchX(0, std::move(p), transactionPx, std::move(newK), std::move(newE));
+            co_await searchX(0, std::move(p), std::move(transactionPx), std::move(newK), std::move(newE));
         } else if (!newE.empty()) {
             co_await search(std::move(p), transactionPx, std::move(newK), std::move(newE));
         }
     }
 }
 
-template<typename... Args>
-__attribute__((noinline)) auto my_lower_bound(Args &&...args) {
-    return std::lower_bound(std::forward<Args>(args)...);
+template<typename P, typename D, typename I>
+void DPEFIM::searchSequential(P &prefix, const D &transactionsOfP, const I &itemsToKeep, const I &itemsToExplore) {
+    incCandidateCount(itemsToExplore.size());
+    for (std::size_t j = 0; j < itemsToExplore.size(); ++j)
+        searchXSequential(j, prefix, transactionsOfP, itemsToKeep, itemsToExplore);
 }
 
-template<typename T>
-auto DPEFIM::calcUtilityAndNextDB(Item x, T &&db, int node, bool allow_scatter) -> std::pair<Utility, Database> {
-    std::size_t alloc_size = 0;
+// searchX() without spawning, migration, scatter, fusion, occurrence indexes, flattening and compaction,
+// none of which pays off for databases small enough to be searched sequentially
+template<typename P, typename D, typename I>
+void DPEFIM::searchXSequential(std::size_t j, P &prefix, const D &transactionsOfP, const I &itemsToKeep,
+                               const I &itemsToExplore) {
+    auto x = itemsToExplore[j];
 
     Utility utilityPx = 0;
-    Database ret(partition_num);
-
-    [[maybe_unused]] auto try_aggresive_merge = [&ret](const Transaction &projected) {
-        for (std::size_t i = 0; i < ret.size(); ++i) {
-            auto &tra = ret[i];
-            if (tra && projected.compare_extension(tra)) {
-                tra.merge(projected);
-                return true;
-            }
+    D transactionPx(transactionsOfP.partition_num());
+    for (std::size_t nid = 0; nid < transactionsOfP.partition_num(); ++nid) {
+        auto [util, db, part_ub] = calcUtilityAndNextDB(x, transactionsOfP.get(nid), static_cast<int>(nid));
+        utilityPx += util;
+        transactionPx.merge(std::move(db));
+    }
+
+    auto extension = extensionLength(prefix.size() + 1);
+    BasicUtilityBinArray<typename D::value_type::utility_type> ub;
+    auto mask = makeItemMask(j, itemsToKeep);
+    for (std::size_t nid = 0; extension != 0 && nid < transactionPx.partition_num(); ++nid)
+        calcUpperBoundsImpl(ub, j, transactionPx.get(nid), itemsToKeep, mask, extension);
+
+    auto minUtil = searchMinUtil();
+    I newK, newE;
+    if (extension != 0)
+        ub.selectItems(itemsToKeep, j + 1, minUtil, newK, newE);
+
+    if (utilityPx < minUtil && newE.empty())
+        return;
+    prefix.push_back(newNameToOldNames[x]);
+    if (utilityPx >= minUtil)
+        addResult(prefix, utilityPx);
+    if (extension == 1)
+        addLastExtensions(prefix, ub, newE);
+    else if (!newE.empty())
+        searchSequential(prefix, transactionPx, newK, newE);
+    prefix.pop_back();
+}
+
+template<typename D, typename I>
+auto DPEFIM::searchBatch(std::size_t bg, std::size_t ed, const I &prefix, const D &transactionsOfP,
+                         const I &itemsToKeep, const I &itemsToExplore) -> nova::task<> {
+    if (shouldSpawn(sumBytes(transactionsOfP))) {
+        auto spawner = std::this_thread::get_id();
+        co_await schedule();
+        addSpawn(spawner);
+    }
+
+    auto depth = prefix.size();
+    I xs(itemsToExplore.begin() + bg, itemsToExplore.begin() + ed);
+
+    std::span<const Item> keep;
+    if (fused_upper_bounds && max_length == 0 && sumBytes(transactionsOfP) >= fused_upper_bounds_min_bytes)
+        keep = std::span<const Item>(itemsToKeep.data(), itemsToKeep.size());
+
+    using Tra = typename D::value_type;
+    std::vector<Projection<Tra>> projected;
+    projected.reserve(ed - bg);
+    for (std::size_t k = bg; k < ed; ++k)
+        projected.emplace_back(0, D(transactionsOfP.partition_num()), BasicUtilityBinArray<typename Tra::utility_type>{});
+
+    for (auto &&parts:
+         co_await partition_map(
+                 transactionsOfP,
+                 [this, depth, bg, keep, &xs](auto &db, auto node) {
+                     return timeScan(db, node, [&] {
+                         return calcUtilitiesAndNextDBs(xs, db, node, depth < thresholds.step3_stop_task_migration_depth, keep, bg);
+                     });
+                 },
+                 [this]([[maybe_unused]] auto &part, std::size_t node) {
+                     return schedule(static_cast<int>(node));
+                 },
+                 [this, depth](auto &part, auto /*id*/) {
+                     return shouldMigrate(depth, part.get_sum_value());
+                 })) {
+        for (std::size_t k = 0; k < parts.size(); ++k) {
+            auto &[util, db, ub] = projected[k];
+            auto &[part_util, part_db, part_ub] = parts[k];
+            util += part_util;
+            db.merge(std::move(part_db));
+            ub.merge(std::move(part_ub));
         }
-        return false;
-    };
+    }
 
-    int consecutive_merge_count = 0;
-    Transaction prevTransaction;
-    int allocNode = node;
+    std::vector<nova::task<>> tasks;
+    tasks.reserve(ed - bg);
+    for (std::size_t k = bg; k < ed; ++k)
+        tasks.emplace_back(searchX(static_cast<int>(k), prefix, transactionsOfP, itemsToKeep, itemsToExplore, nullptr,
+                                   std::move(projected[k - bg])));
+    co_await nova::when_all(std::move(tasks));
+}
 
-    for (auto &transaction: db) {
-        auto iterX = my_lower_bound(
-                transaction.begin(), transaction.end(), Transaction::Elem{x, 0},
-                [](const auto &l, const auto &r) { return l.first < r.first; });
-        if (iterX == transaction.end() || iterX->first != x) { continue; }
+template<typename... Args>
+__attribute__((noinline)) auto my_lower_bound(Args &&...args) {
+    return std::lower_bound(std::forward<Args>(args)...);
+}
+
+// projection of one partition with an item: transactions are added in order with the position of the item.
+// Upper bounds of itemsToKeep are accumulated from each projected transaction when it is emitted (just after it is
+// compared with the next one) if itemsToKeep is not empty.
+template<typename Tra>
+struct DPEFIM::Projector {
+    Projector(DPEFIM *self, int node, bool allow_scatter, std::span<const Item> itemsToKeep, std::size_t j)
+        : self(self), node(node), allow_scatter(allow_scatter), allocNode(node),
+          arena(self->use_arena && self->pmem_alloc_type == PmemAllocType::None),
+          arenas(arena ? self->partition_num + 1 : 0),
+          itemsToKeep(itemsToKeep),
+          ret(self->partition_num) {
+        if (!itemsToKeep.empty()) {
+            ub.reset(itemsToKeep[j], itemsToKeep.back());
+            mask = self->makeItemMask(j, itemsToKeep);
+        }
+    }
+
+    // `iterX` points to x in `transaction`
+    template<typename Iter>
+    void add(const Tra &transaction, Iter iterX) {
         if (iterX + 1 == transaction.end()) {
             utilityPx += iterX->second + transaction.prefix_utility;
         } else {
-            auto projected = transaction.projection(iterX);
+            auto projected = arena ? transaction.projection_view(iterX) : transaction.projection(iterX);
             utilityPx += projected.prefix_utility;
-            if (!prevTransaction) {
-                prevTransaction = std::move(projected);
-                // } else if (try_aggresive_merge(projected)) {
-                // pass
-            } else if (projected.compare_extension(prevTransaction)) {
-                if (consecutive_merge_count == 0) {
-                    if (allow_scatter && (alloc_size > this->thresholds.step3_scatter_alloc_threshold / partition_num)) {
-                        // scatter
-                        allocNode = (allocNode + 1) % partition_num;
-                        prevTransaction = this->cloneTransaction(prevTransaction, allocNode);
-                        addMalloc(prevTransaction.bytes());
-                        alloc_size += prevTransaction.bytes();
-                    } else {
-                        // non scatter
-                        prevTransaction = this->cloneTransaction(prevTransaction, std::nullopt);
-                        allocNode = node;
-                        addMalloc(prevTransaction.bytes());
-                        alloc_size += prevTransaction.bytes();
+            if (self->hash_merge) {
+                auto hash = projected.hash_extension();
+                if (auto i = mergeTable.find(projected, hash)) {
+                    auto &[count, n] = mergeInfo[*i];
+                    if (count++ == 0) {
+                        cloneToMerge(mergeTable[*i]);
+                        n = allocNode;
                     }
+                    mergeTable[*i].merge(projected);
+                } else {
+                    mergeTable.add(std::move(projected), hash);
+                    mergeInfo.emplace_back(0, node);
                 }
+            } else if (!prevTransaction) {
+                prevTransaction = std::move(projected);
+            } else if (projected.compare_extension(prevTransaction)) {
+                if (consecutive_merge_count == 0)
+                    cloneToMerge(prevTransaction);
                 prevTransaction.merge(std::move(projected));
                 consecutive_merge_count++;
             } else {
-                ret.get(allocNode).push_back(std::move(prevTransaction));
+                emit(std::move(prevTransaction), allocNode);
                 prevTransaction = std::move(projected);
                 consecutive_merge_count = 0;
             }
         }
     }
 
-    if (prevTransaction)
-        ret.get(allocNode).push_back(std::move(prevTransaction));
+    Projection<Tra> finish() {
+        if (prevTransaction)
+            emit(std::move(prevTransaction), allocNode);
+        auto merged = mergeTable.release();
+        for (std::size_t i = 0; i < merged.size(); ++i)
+            emit(std::move(merged[i]), mergeInfo[i].second);
+        return Projection<Tra>(utilityPx, std::move(ret), std::move(ub));
+    }
+
+private:
+    void emit(Tra &&tra, int alloc_node) {
+        if (!mask.empty())
+            addUpperBounds(ub, tra, mask);
+        else if (!itemsToKeep.empty())
+            addUpperBounds(ub, tra, itemsToKeep);
+        ret.get(alloc_node).push_back(std::move(tra));
+    }
+
+    Tra clone(const Tra &tra, std::optional<int> alloc_node) {
+        if (!arena)
+            return self->cloneTransaction(tra, alloc_node);
+        auto &a = arenas[alloc_node.value_or(self->partition_num)];
+        if (!a)
+            a = self->makeArena(alloc_node);
+        return tra.clone_into([&a](std::size_t size) { return a->allocate(size, alignof(typename Tra::Elem)); }, a);
+    }
+
+    // copy a transaction before the first merge into it (on the next node if enough bytes are allocated on this node)
+    void cloneToMerge(Tra &tra) {
+        auto partition_num = self->partition_num;
+        if (allow_scatter && (alloc_size > self->scatterAllocThreshold() / partition_num)) {
+            // scatter
+            allocNode = (allocNode + 1) % partition_num;
+            tra = clone(tra, allocNode);
+        } else {
+            // non scatter
+            tra = clone(tra, std::nullopt);
+            allocNode = node;
+        }
+        self->addMalloc(tra.bytes());
+        self->addAlloc(allocNode, tra.bytes());
+        alloc_size += tra.bytes();
+    }
+
+    DPEFIM *self;
+    int node;
+    bool allow_scatter;
+
+    std::size_t alloc_size = 0;
+    int consecutive_merge_count = 0;
+    Tra prevTransaction;
+    int allocNode;
+
+    // arenas[n] for scatter to node n, arenas[partition_num] for the current thread
+    bool arena;
+    std::vector<std::shared_ptr<Arena>> arenas;
 
-    return std::make_pair(utilityPx, std::move(ret));
+    // for hash_merge: # of merges and the node of each transaction in the table
+    MergeTable<Tra> mergeTable;
+    std::vector<std::pair<std::size_t, int>> mergeInfo;
+
+    std::span<const Item> itemsToKeep;
+    ItemMask mask;// of itemsToKeep[j..] (empty if not use_item_mask)
+    BasicUtilityBinArray<typename Tra::utility_type> ub;
+
+    Utility utilityPx = 0;
+    BasicDatabase<Tra> ret;
+};
+
+template<typename T>
+auto DPEFIM::calcUtilityAndNextDB(Item x, T &&db, int node, bool allow_scatter, const OccurrenceIndex *index,
+                                  std::span<const Item> itemsToKeep, std::size_t j)
+        -> Projection<typename std::remove_cvref_t<T>::value_type> {
+    using Tra = typename std::remove_cvref_t<T>::value_type;
+
+    Projector<Tra> projector(this, node, allow_scatter, itemsToKeep, j);
+    if (index) {
+        auto bg = db.begin();
+        for (auto [tid, pos]: index->find(x)) {
+            auto &transaction = *(bg + tid);
+            projector.add(transaction, transaction.begin() + pos);
+        }
+    } else {
+        for (auto &transaction: db) {
+            auto iterX = my_lower_bound(
+                    transaction.begin(), transaction.end(), typename Tra::Elem{static_cast<typename Tra::item_type>(x), 0},
+                    [](const auto &l, const auto &r) { return l.first < r.first; });
+            if (iterX == transaction.end() || iterX->first != x) { continue; }
+            projector.add(transaction, iterX);
+        }
+    }
+    return projector.finish();
 }
 
+template<typename T, typename I>
+auto DPEFIM::calcUtilitiesAndNextDBs(const I &xs, T &&db, int node, bool allow_scatter,
+                                     std::span<const Item> itemsToKeep, std::size_t j)
+        -> std::vector<Projection<typename std::remove_cvref_t<T>::value_type>> {
+    using Tra = typename std::remove_cvref_t<T>::value_type;
 
-template<typename D, typename I>
-void DPEFIM::calcUpperBoundsImpl(UtilityBinArray &ub, std::size_t j, const D &db, const I &itemsToKeep) const {
+    std::vector<Projector<Tra>> projectors;
+    projectors.reserve(xs.size());
+    for (std::size_t k = 0; k < xs.size(); ++k)
+        projectors.emplace_back(this, node, allow_scatter, itemsToKeep, j + k);
+
+    // xs and the items of each transaction are in ascending order, so every x is searched after the previous one
+    for (auto &transaction: db) {
+        auto iterX = transaction.begin();
+        for (std::size_t k = 0; k < xs.size(); ++k) {
+            iterX = my_lower_bound(
+                    iterX, transaction.end(), typename Tra::Elem{static_cast<typename Tra::item_type>(xs[k]), 0},
+                    [](const auto &l, const auto &r) { return l.first < r.first; });
+            if (iterX == transaction.end())
+                break;
+            if (iterX->first == xs[k])
+                projectors[k].add(transaction, iterX);
+        }
+    }
+
+    std::vector<Projection<Tra>> ret;
+    ret.reserve(xs.size());
+    for (auto &projector: projectors)
+        ret.push_back(projector.finish());
+    return ret;
+}
+
+
+template<typename UB, typename D, typename I>
+void DPEFIM::calcUpperBoundsImpl(UB &ub, std::size_t j, const D &db, const I &itemsToKeep, const ItemMask &mask,
+                                 std::size_t extension) const {
     if (ub.size() == 0)
         ub.reset(itemsToKeep[j], itemsToKeep.back());
-    for (const auto &transaction: db) {
-        Utility sum_remaining_utility = 0;
-        auto ed = itemsToKeep.end();
-        for (auto it = transaction.rbegin(); it != transaction.rend(); ++it) {
-            auto [item, utility] = *it;
-            auto lb = my_lower_bound(itemsToKeep.begin(), ed, item);
-            if (lb != ed && *lb == item) {// contains
-                sum_remaining_utility += utility;
-                ub.getSU(item) += sum_remaining_utility + transaction.prefix_utility;
-                ub.getLU(item) += transaction.transaction_utility + transaction.prefix_utility;
-            }
-            ed = lb;
-        }
+    // extensions cannot be longer than the # of items to keep after x anyway
+    if (extension < itemsToKeep.size() - j - 1) {
+        LargestUtilities largest(extension);
+        auto keep = mask.empty() ? ItemMask(itemsToKeep.begin() + j, itemsToKeep.end()) : ItemMask();
+        for (const auto &transaction: db)
+            addUpperBounds(ub, transaction, mask.empty() ? keep : mask, largest);
+    } else if (!mask.empty()) {
+        for (const auto &transaction: db)
+            addUpperBounds(ub, transaction, mask);
+    } else {
+        for (const auto &transaction: db)
+            addUpperBounds(ub, transaction, itemsToKeep);
     }
 }
 
@@ -377,12 +811,12 @@ auto DPEFIM::calcUpperBounds(std::size_t j, const D &transactionsPx, const I &it
     if constexpr (no_use_thread_local) {
         UtilityBinArray utilityBinArray;
         utilityBinArray.reset(itemsToKeep[j], itemsToKeep.back());
-        calcUpperBoundsImpl(utilityBinArray, j, transactionsPx, itemsToKeep);
+        calcUpperBoundsImpl(utilityBinArray, j, transactionsPx, itemsToKeep, makeItemMask(j, itemsToKeep));
         return utilityBinArray;
     } else {
         thread_local UtilityBinArray utilityBinArray;
         utilityBinArray.reset(itemsToKeep[j], itemsToKeep.back());
-        calcUpperBoundsImpl(utilityBinArray, j, transactionsPx, itemsToKeep);
+        calcUpperBoundsImpl(utilityBinArray, j, transactionsPx, itemsToKeep, makeItemMask(j, itemsToKeep));
         return utilityBinArray;
     }
 }
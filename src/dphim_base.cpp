@@ -1,5 +1,9 @@
 #include <dphim/dphim_base.hpp>
+#include <dphim/parse.hpp>
+#include <dphim/util/io_uring_reader.hpp>
+#include <dphim/util/mapped_file.hpp>
 #include <dphim/util/pmem_allocator.hpp>
+#include <dphim/util/raii.hpp>
 #include <nova/jemalloc.hpp>
 #include <nova/when_all.hpp>
 
@@ -10,82 +14,216 @@
 #include <sys/stat.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
 #include <iostream>
+#include <mutex>
+#include <numeric>
 #include <string>
+#include <thread>
 
 namespace dphim {
 
-std::pair<Transaction, Item> DphimBase::parseOneLine(std::string line, [[maybe_unused]] int node) {
-    Transaction tra;
-    Item max_item = 0;
+namespace {
+
+// Resumes a reader on `node` when a read of `ring` completes, so that its worker runs the parse tasks queued by the
+// reader instead of blocking on the read (the reader would resume first after a bare schedule(), as workers are LIFO).
+// A helper thread blocks in IoUringReader::wait() on behalf of the suspended reader.
+struct UringCompletionWaiter {
+    UringCompletionWaiter(nova::scheduler_base *sched, IoUringReader &ring, int node)
+        : sched(sched), ring(ring), node(node), thread([this] { run(); }) {}
+    UringCompletionWaiter(const UringCompletionWaiter &) = delete;
+    UringCompletionWaiter &operator=(const UringCompletionWaiter &) = delete;
+    ~UringCompletionWaiter() {
+        {
+            std::lock_guard lk(mtx);
+            stop = true;
+        }
+        cv.notify_one();
+        thread.join();
+    }
 
-    try {
-        std::size_t i = 0, j = 0;
-        std::vector<std::pair<Item, Utility>> buf;
-        while (i < line.size()) {
+    auto next() {
+        struct awaiter {
+            UringCompletionWaiter *self;
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(nova::coro::coroutine_handle<> h) {
+                self->resume.coro = h;
+                {
+                    std::lock_guard lk(self->mtx);
+                    self->requested = true;
+                }
+                self->cv.notify_one();
+            }
+            IoUringReader::Completion await_resume() {
+                if (self->error)
+                    std::rethrow_exception(std::exchange(self->error, nullptr));
+                return self->completion;
+            }
+        };
+        return awaiter{this};
+    }
+
+private:
+    struct Resume : nova::task_base {
+        void execute() override {
+            coro.resume();
+        }
+        nova::coro::coroutine_handle<> coro;
+    };
+
+    void run() {
+        while (true) {
+            {
+                std::unique_lock lk(mtx);
+                cv.wait(lk, [this] { return requested || stop; });
+                if (stop)
+                    return;
+                requested = false;
+            }
             try {
-                auto item = static_cast<Item>(std::stol(line.data() + i, &j));
-                max_item = std::max(max_item, item);
-                i += j + 1;
-                buf.emplace_back(item, 0);
-                if (line[i - 1] == ':')
-                    break;
-            } catch (std::invalid_argument &e) {
-                std::cerr << e.what() << ": " << __LINE__ << " " << line << std::endl;
+                completion = ring.wait();
+            } catch (...) {
+                error = std::current_exception();
             }
+            sched->post(&resume, node);
         }
+    }
 
-        if (pmem_alloc_type != PmemAllocType::None) {
+    nova::scheduler_base *sched;
+    IoUringReader &ring;
+    const int node;
+    Resume resume;
+    IoUringReader::Completion completion{};
+    std::exception_ptr error;
+    std::mutex mtx;
+    std::condition_variable cv;
+    bool requested = false, stop = false;
+    std::thread thread;
+};
+
+}// namespace
+
+void DphimBase::reserveTransaction(Transaction &tra, std::size_t n, [[maybe_unused]] int node) {
+    if (pmem_alloc_type != PmemAllocType::None) {
 #ifdef DPHIM_PMEM
-            auto pmem_allocator = get_pmem_allocator(node < 0 ? std::nullopt : std::optional(node));
-            tra.reserve(
-                    buf.size(),
-                    [=](auto size) { return pmem_allocator->alloc(size); },
-                    [=]([[maybe_unused]] auto size) {
-                        return [=](auto *p) {
-                            using T = std::remove_pointer_t<std::remove_cvref_t<decltype(p)>>;
-                            p->~T();
-                            pmem_allocator->dealloc(p); };
-                    });
+        auto pmem_allocator = get_pmem_allocator(node < 0 ? std::nullopt : std::optional(node));
+        tra.reserve(
+                n,
+                [=](auto size) { return pmem_allocator->alloc(size); },
+                [=]([[maybe_unused]] auto size) {
+                    return [=](auto *p) {
+                        using T = std::remove_pointer_t<std::remove_cvref_t<decltype(p)>>;
+                        p->~T();
+                        pmem_allocator->dealloc(p); };
+                });
 #else
-            throw std::runtime_error("pmem is not supported");
+        throw std::runtime_error("pmem is not supported");
 #endif
-        } else {
-            tra.reserve(buf.size());
-        }
+    } else {
+        tra.reserve(n);
+    }
+}
 
-        for (auto &&e: buf)
-            tra.push_back(std::move(e));
+std::pair<Transaction, Item> DphimBase::parseOneLine(std::string_view line, [[maybe_unused]] int node) {
+    Transaction tra;
+    Item max_item = 0;
 
-        try {
-            tra.transaction_utility = static_cast<Utility>(std::stol(line.data() + i, &j));
-        } catch (std::invalid_argument &e) {
-            std::cerr << e.what() << ": " << __LINE__ << " " << line << std::endl;
-        }
+    try {
+        max_item = decodeTransaction(line, tra, [this, node](Transaction &t, std::size_t n) {
+            reserveTransaction(t, n, node);
+        });
+    } catch (std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        std::cerr << "input: " << line << std::endl;
+        throw;
+    }
+    return std::make_pair(std::move(tra), max_item);
+}
 
-        i += j + 1;
-        if (line[i - 1] != ':')
-            throw std::runtime_error("failed to parse");
+std::pair<Transaction, Item> DphimBase::parseOneLine(const TokenizedLines &tl, const TokenizedLine &line, const char *ed, [[maybe_unused]] int node) {
+    Transaction tra;
+    Item max_item = 0;
 
-        for (auto &[item, util]: tra) {
-            try {
-                util = static_cast<Utility>(std::stol(line.data() + i, &j));
-                i += j + 1;
-            } catch (std::invalid_argument &e) {
-                std::cerr << e.what() << ": " << __LINE__ << " " << line << std::endl;
-            }
-        }
+    try {
+        max_item = decodeTokenizedTransaction(tl, line, ed, tra, [this, node](Transaction &t, std::size_t n) {
+            reserveTransaction(t, n, node);
+        });
     } catch (std::exception &e) {
         std::cerr << e.what() << std::endl;
-        std::cerr << "input: " << line << std::endl;
+        std::cerr << "input: " << tl.line(line) << std::endl;
         throw;
     }
     return std::make_pair(std::move(tra), max_item);
 }
 
+std::pair<Transactions, Item> DphimBase::parseTokenizedRange(const char *bg, const char *ed, int node) {
+    static thread_local TokenizedLines tl;
+    tokenizeLines(bg, ed, tl);
+    Transactions transactions;
+    transactions.reserve(tl.lines.size());
+    Item max_item = 0;
+    auto *twu = parsed_twu ? &parsed_twu->local() : nullptr;
+    for (const auto &line: tl.lines) {
+        auto [tra, mI] = parseOneLine(tl, line, ed, node);
+        if (twu)
+            twu->add(tra);
+        transactions.push_back(std::move(tra));
+        max_item = std::max(max_item, mI);
+    }
+    return std::make_pair(std::move(transactions), max_item);
+}
+
+auto DphimBase::ParseQueue::push(Task task) -> nova::task<> {
+    pushed += 1;
+    if (max_inflight == 0) {
+        if (inflight.empty())
+            inflight.push_back(nova::when_all(std::vector<Task>{}));
+        inflight.back().add_task(std::move(task), nova::launch::immediate);
+        co_return;
+    }
+    while (inflight.size() >= max_inflight)
+        co_await pop();
+    inflight.push_back(nova::when_all(std::vector<Task>{}));
+    inflight.back().add_task(std::move(task), nova::launch::immediate);
+}
+
+auto DphimBase::ParseQueue::pop() -> nova::task<> {
+    auto front = std::move(inflight.front());
+    inflight.pop_front();
+    auto results = co_await std::move(front);
+    if (self->sched->get_current_node_id().has_value() && node > 0) {
+        while (self->sched->get_current_node_id().value() != node)
+            co_await self->schedule(node);
+    }
+    for (auto &&[trans, mI]: results) {
+        res.append(std::move(trans));
+        max_item = std::max(max_item, mI);
+    }
+}
+
+auto DphimBase::ParseQueue::finish() -> nova::task<std::pair<Transactions, Item>> {
+    while (!inflight.empty())
+        co_await pop();
+    co_return std::make_pair(std::move(res), max_item);
+}
+
 auto DphimBase::parseTransactions(std::function<std::size_t(std::size_t)> get_partition_num) -> nova::task<std::pair<Database, Item>> {
+    if (fused_twu)
+        parsed_twu = std::make_unique<ConcurrentTWU>();
+
+    auto files = listInputFiles(input_path);
+    if (files.size() > 1)
+        co_return co_await parseShards(files, std::move(get_partition_num));
+    // the only file, e.g. of a directory with one file
+    const auto &path = files.front();
+
+    if (isBinaryDatabase(path))
+        co_return co_await loadBinaryDatabase(path, std::move(get_partition_num));
+
     struct stat st;
-    if (stat(input_path.c_str(), &st) == -1)
+    if (stat(path.c_str(), &st) == -1)
         throw std::runtime_error(strerror(errno));
 
     auto fsize = st.st_size;
@@ -97,7 +235,7 @@ auto DphimBase::parseTransactions(std::function<std::size_t(std::size_t)> get_pa
     for (auto i = 0ul; i < partition_num; ++i) {
         off_t bg = diff * i;
         off_t ed = std::min<off_t>(diff * (i + 1), fsize + 1);
-        tasks.emplace_back(parseFileRange(input_path.c_str(), bg, ed, i));
+        tasks.emplace_back(parseFileRange(path.c_str(), bg, ed, i));
     }
 
     if (is_debug_mode())
@@ -113,8 +251,79 @@ auto DphimBase::parseTransactions(std::function<std::size_t(std::size_t)> get_pa
     co_return std::pair<Database, Item>{std::move(db), maxItem};
 }
 
+auto DphimBase::parseShards(const std::vector<std::string> &paths, std::function<std::size_t(std::size_t)> get_partition_num)
+        -> nova::task<std::pair<Database, Item>> {
+    std::vector<off_t> sizes;
+    off_t total_size = 0;
+    for (const auto &path: paths) {
+        struct stat st;
+        if (stat(path.c_str(), &st) == -1)
+            throw std::runtime_error(path + ": " + strerror(errno));
+        sizes.push_back(st.st_size);
+        total_size += st.st_size;
+    }
+
+    auto partition_num = get_partition_num ? get_partition_num(total_size) : 1;
+    partition_num = std::clamp<std::size_t>(partition_num, 1, paths.size());
+
+    // assign the largest remaining shard to the partition with the fewest bytes
+    std::vector<std::size_t> order(paths.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](auto l, auto r) { return sizes[l] > sizes[r]; });
+    std::vector<off_t> partition_size(partition_num, 0);
+    std::vector<std::size_t> shard_partition(paths.size());
+    for (auto i: order) {
+        auto part = std::min_element(partition_size.begin(), partition_size.end()) - partition_size.begin();
+        shard_partition[i] = part;
+        partition_size[part] += sizes[i];
+    }
+
+    if (is_debug_mode()) {
+        std::cerr << "# of shards: " << paths.size() << " (" << total_size << " bytes)" << std::endl;
+        for (std::size_t i = 0; i < partition_num; ++i)
+            std::cerr << "  partition " << i << ": " << partition_size[i] << " bytes" << std::endl;
+    }
+
+    std::vector<nova::task<std::pair<Transactions, Item>>> tasks;
+    tasks.reserve(paths.size());
+    for (std::size_t i = 0; i < paths.size(); ++i)
+        tasks.emplace_back(parseShard(paths[i], shard_partition[i]));
+
+    Database db(partition_num);
+    Item maxItem = 0;
+    std::size_t i = 0;
+    for (auto &&[trans, mI]: co_await nova::when_all(std::move(tasks))) {
+        db.get(shard_partition[i++]).append(std::move(trans));
+        maxItem = std::max(mI, maxItem);
+    }
+    co_return std::pair<Database, Item>{std::move(db), maxItem};
+}
+
+auto DphimBase::parseShard(const std::string &path, int node) -> nova::task<std::pair<Transactions, Item>> {
+    if (isBinaryDatabase(path)) {
+        BinaryDatabase bin(path);
+        auto transactions = co_await loadBinaryRange(bin, 0, bin.size(), node);
+        co_return std::make_pair(std::move(transactions), bin.max_item());
+    }
+
+    struct stat st;
+    if (stat(path.c_str(), &st) == -1)
+        throw std::runtime_error(path + ": " + strerror(errno));
+    co_return co_await parseFileRange(path.c_str(), 0, st.st_size, node);
+}
+
 auto DphimBase::parseFileRange(const char *pathname, off_t bg, off_t ed, int node) -> nova::task<std::pair<Transactions, Item>> {
 
+    if (parser_type == ParserType::Mmap)
+        co_return co_await parseMappedFileRange(pathname, bg, ed, node);
+
+    if (parser_type == ParserType::Uring) {
+        if (IoUringReader::available())
+            co_return co_await parseUringFileRange(pathname, bg, ed, node);
+        if (is_debug_mode())
+            std::cerr << "io_uring is not available: fall back to pread" << std::endl;
+    }
+
     co_await schedule();
 
     if (sched->get_current_node_id().has_value() && node > 0) {
@@ -131,8 +340,11 @@ auto DphimBase::parseFileRange(const char *pathname, off_t bg, off_t ed, int nod
             std::cerr << __PRETTY_FUNCTION__ << ": " << __LINE__ << " " << e.what() << " " << lines.size() << std::endl;
         }
         Item I = 0;
+        auto *twu = self->parsed_twu ? &self->parsed_twu->local() : nullptr;
         for (auto &line: lines) {
-            auto [tra, mI] = self->parseOneLine(std::move(line), node);
+            auto [tra, mI] = self->parseOneLine(line, node);
+            if (twu)
+                twu->add(tra);
             transactions.push_back(std::move(tra));
             I = std::max(I, mI);
         }
@@ -142,6 +354,7 @@ auto DphimBase::parseFileRange(const char *pathname, off_t bg, off_t ed, int nod
     int fd = open(pathname, O_RDONLY);
     if (fd == -1)
         throw std::runtime_error(strerror(errno));
+    RAII close_fd([fd] { close(fd); });
 
     if (auto err = posix_fadvise(fd, bg, ed - bg, POSIX_FADV_SEQUENTIAL); err != 0)
         throw std::runtime_error(strerror(err));
@@ -149,10 +362,7 @@ auto DphimBase::parseFileRange(const char *pathname, off_t bg, off_t ed, int nod
     std::vector<std::string> lines;
     std::string line;
 
-    auto launch_type = nova::launch::immediate;
-    auto when_all_parse = nova::when_all(std::vector<nova::task<std::pair<Transactions, Item>>>{});
-    std::size_t parse_task_num = 0;
-    std::size_t transaction_num = 0;
+    ParseQueue queue(this, node, parse_inflight);
 
     constexpr std::size_t buf_size = 4092;
     alignas(alignof(std::max_align_t)) char buf[buf_size];
@@ -189,33 +399,328 @@ auto DphimBase::parseFileRange(const char *pathname, off_t bg, off_t ed, int nod
             }
 
             if (lines.size() >= 500) {// parse task size
-                transaction_num += lines.size();
-                parse_task_num += 1;
-                when_all_parse.add_task(parse_task(this, node, std::move(lines)), launch_type);
+                co_await queue.push(parse_task(this, node, std::move(lines)));
                 lines.clear();
             }
         }
         line.insert(line.size(), prev, buf + buf_size - prev);
         offset += bytes_read;
     }
-    close(fd);
 
-    transaction_num += lines.size();
-    parse_task_num += 1;
-    when_all_parse.add_task(parse_task(this, node, std::move(lines)), launch_type);
+    co_await queue.push(parse_task(this, node, std::move(lines)));
 
     if (is_debug_mode()) {
-        std::cerr << "# of parse tasks (node: " << node << "): " << parse_task_num << std::endl;
+        std::cerr << "# of parse tasks (node: " << node << "): " << queue.task_num() << std::endl;
     }
 
-    Transactions res;
-    res.reserve(transaction_num);
-    Item max_item = 0;
-    for (auto &&[trans, mI]: co_await std::move(when_all_parse)) {
-        std::copy(std::make_move_iterator(trans.begin()), std::make_move_iterator(trans.end()), std::back_inserter(res));
-        max_item = std::max(max_item, mI);
+    co_return co_await queue.finish();
+}
+
+auto DphimBase::parseMappedFileRange(const char *pathname, off_t bg, off_t ed, int node) -> nova::task<std::pair<Transactions, Item>> {
+
+    co_await schedule();
+
+    if (sched->get_current_node_id().has_value() && node > 0) {
+        while (sched->get_current_node_id().value() != node)
+            co_await schedule(node);
     }
 
-    co_return std::make_pair(std::move(res), max_item);
+    auto parse_task = [](auto self, auto node, const char *bg, const char *ed) -> nova::task<std::pair<Transactions, Item>> {
+        co_await self->schedule();
+        co_return self->parseTokenizedRange(bg, ed, node);
+    };
+
+    MappedFile file(pathname, bg);
+
+    // this range owns the lines that end at or after the first '\n' at `bg`, up to the first '\n' at `ed`
+    const char *first = file.begin();
+    const char *last = file.begin() + std::min<std::size_t>(ed - bg, file.size());
+    if (bg != 0) {
+        const auto *p = static_cast<const char *>(memchr(first, '\n', file.end() - first));
+        first = p ? p + 1 : file.end();
+    }
+    if (last < file.end()) {
+        const auto *p = static_cast<const char *>(memchr(last, '\n', file.end() - last));
+        last = p ? p + 1 : file.end();
+    }
+    last = std::max(first, last);
+
+    ParseQueue queue(this, node, parse_inflight);
+
+    const char *chunk_bg = first;
+    std::size_t line_num = 0;
+    for (const char *prev = first; prev < last;) {
+        const auto *p = static_cast<const char *>(memchr(prev, '\n', last - prev));
+        prev = p ? p + 1 : last;
+        if (++line_num >= 500 || prev == last) {// parse task size
+            co_await queue.push(parse_task(this, node, chunk_bg, prev));
+            chunk_bg = prev;
+            line_num = 0;
+        }
+    }
+    if (queue.task_num() == 0)
+        co_await queue.push(parse_task(this, node, last, last));
+
+    if (is_debug_mode()) {
+        std::cerr << "# of parse tasks (node: " << node << "): " << queue.task_num() << std::endl;
+    }
+
+    co_return co_await queue.finish();
+}
+
+auto DphimBase::parseUringFileRange(const char *pathname, off_t bg, off_t ed, int node) -> nova::task<std::pair<Transactions, Item>> {
+
+    co_await schedule();
+
+    if (sched->get_current_node_id().has_value() && node > 0) {
+        while (sched->get_current_node_id().value() != node)
+            co_await schedule(node);
+    }
+
+    // the reader stays on this node while waiting for reads
+    const int home = sched->get_current_node_id().value_or(nova::OPTION_DEFAULT);
+
+    // a chunk is parsed in place in the read buffer it shares with its slot (see submit())
+    struct Chunk {
+        std::shared_ptr<const char[]> owner;
+        const char *bg, *ed;
+    };
+    auto parse_task = [](auto self, auto node, Chunk chunk) -> nova::task<std::pair<Transactions, Item>> {
+        co_await self->schedule();
+        co_return self->parseTokenizedRange(chunk.bg, chunk.ed, node);
+    };
+
+    int fd = open(pathname, O_RDONLY);
+    if (fd == -1)
+        throw std::runtime_error(strerror(errno));
+    RAII close_fd([fd] { close(fd); });
+    struct stat st;
+    if (fstat(fd, &st) == -1)
+        throw std::runtime_error(strerror(errno));
+    const off_t fsize = st.st_size;
+
+    constexpr std::size_t queue_depth = 4;
+    constexpr std::size_t buf_size = 4ul << 20;   // size of one read
+    constexpr std::size_t chunk_size = 64ul << 10;// parse task size
+
+    struct Slot {
+        std::shared_ptr<char[]> buf;
+        off_t offset = 0;
+        int res = 0;
+        bool done = false;
+    };
+    std::vector<Slot> slots(queue_depth);
+    IoUringReader ring(fd, queue_depth);
+
+    ParseQueue queue(this, node, parse_inflight);
+    std::vector<Chunk> chunks;// parse tasks to be pushed to `queue`
+
+    // same ownership of lines as parseMappedFileRange():
+    // from the line after the first '\n' at `bg` to the line including the first '\n' at `ed`
+    bool started = bg == 0;
+    bool finished = false;
+    std::string pending;// the beginning of a line that continues to the next buffer
+
+    // [bg, ed) of `owner`, whose first line begins with `pending` (copied with the rest of the line)
+    auto spawn = [&](const std::shared_ptr<char[]> &owner, const char *bg, const char *ed) {
+        if (!pending.empty()) {
+            const auto *q = bg != ed ? static_cast<const char *>(memchr(bg, '\n', ed - bg)) : nullptr;
+            const char *line_ed = q ? q + 1 : ed;
+            auto size = pending.size() + (line_ed - bg);
+            std::shared_ptr<char[]> line(new char[size]);
+            std::copy(bg, line_ed, std::copy(pending.begin(), pending.end(), line.get()));
+            chunks.push_back(Chunk{line, line.get(), line.get() + size});
+            pending.clear();
+            bg = line_ed;
+        }
+        if (bg != ed)
+            chunks.push_back(Chunk{owner, bg, ed});
+    };
+
+    auto consume = [&](const std::shared_ptr<char[]> &owner, std::size_t len, off_t offset) {
+        const char *buf = owner.get();
+        const char *p = buf, *e = buf + len;
+        if (!started) {
+            const auto *q = static_cast<const char *>(memchr(p, '\n', e - p));
+            if (!q)
+                return;
+            if (offset + (q - buf) >= ed) {
+                finished = true;
+                return;
+            }
+            started = true;
+            p = q + 1;
+        }
+
+        const char *stop = e;
+        if (offset + static_cast<off_t>(len) > ed) {
+            const char *from = std::max(p, buf + std::max<off_t>(ed - offset, 0));
+            if (const auto *q = static_cast<const char *>(memchr(from, '\n', e - from))) {
+                stop = q + 1;
+                finished = true;
+            }
+        }
+
+        while (p < stop) {
+            const char *cut = nullptr;
+            if (static_cast<std::size_t>(stop - p) > chunk_size) {
+                if (const auto *q = static_cast<const char *>(memchr(p + chunk_size, '\n', stop - p - chunk_size)))
+                    cut = q + 1;
+            }
+            if (!cut) {
+                if (finished)
+                    cut = stop;
+                else if (const auto *q = static_cast<const char *>(memrchr(p, '\n', stop - p)))
+                    cut = q + 1;
+            }
+            if (!cut) {
+                pending.append(p, stop);
+                break;
+            }
+            spawn(owner, p, cut);
+            p = cut;
+        }
+    };
+
+    off_t next_offset = bg;
+    std::size_t submitted = 0, processed = 0;
+    auto submit = [&] {
+        while (!finished && submitted - processed < queue_depth && next_offset < fsize) {
+            auto &slot = slots[submitted % queue_depth];
+            // the buffer is reused only after every parse task of its chunks has released it
+            if (!slot.buf || slot.buf.use_count() > 1)
+                slot.buf = std::shared_ptr<char[]>(new char[buf_size]);
+            slot.offset = next_offset;
+            slot.done = false;
+            ring.submit_read(slot.buf.get(), buf_size, next_offset, submitted);
+            next_offset += buf_size;
+            submitted += 1;
+        }
+    };
+
+    // without tasks to run meanwhile (sched_no_await), the reader simply blocks on reads
+    std::optional<UringCompletionWaiter> waiter;
+    if (!sched_no_await)
+        waiter.emplace(sched.get(), ring, home);
+
+    submit();
+    while (processed < submitted) {
+        auto &slot = slots[processed % queue_depth];
+        while (!slot.done) {
+            auto c = ring.poll();
+            if (!c)
+                c = waiter ? co_await waiter->next() : ring.wait();
+            auto &s = slots[c->user_data % queue_depth];
+            s.res = c->res;
+            s.done = true;
+        }
+        if (slot.res < 0)
+            throw std::runtime_error(std::string("io_uring read: ") + strerror(-slot.res));
+
+        // complete a short read synchronously (this should not happen for regular files)
+        auto len = static_cast<std::size_t>(slot.res);
+        auto want = static_cast<std::size_t>(std::min<off_t>(buf_size, fsize - slot.offset));
+        while (len < want) {
+            auto r = pread(fd, slot.buf.get() + len, want - len, slot.offset + len);
+            if (r <= 0)
+                throw std::runtime_error("read failed");
+            len += r;
+        }
+
+        if (!finished)
+            consume(slot.buf, len, slot.offset);
+        processed += 1;
+        submit();
+
+        for (auto &chunk: chunks)
+            co_await queue.push(parse_task(this, node, std::move(chunk)));
+        chunks.clear();
+    }
+
+    // the last line without '\n'
+    if (!finished && started && !pending.empty())
+        spawn(nullptr, nullptr, nullptr);
+    if (queue.task_num() == 0 && chunks.empty())
+        chunks.push_back(Chunk{nullptr, nullptr, nullptr});
+    for (auto &chunk: chunks)
+        co_await queue.push(parse_task(this, node, std::move(chunk)));
+
+    if (is_debug_mode()) {
+        std::cerr << "# of io_uring reads (node: " << node << "): " << submitted << std::endl;
+        std::cerr << "# of parse tasks (node: " << node << "): " << queue.task_num() << std::endl;
+    }
+
+    co_return co_await queue.finish();
+}
+
+auto DphimBase::loadBinaryDatabase(const std::string &path, std::function<std::size_t(std::size_t)> get_partition_num) -> nova::task<std::pair<Database, Item>> {
+    struct stat st;
+    if (stat(path.c_str(), &st) == -1)
+        throw std::runtime_error(strerror(errno));
+
+    BinaryDatabase bin(path);
+    auto partition_num = get_partition_num ? get_partition_num(st.st_size) : 1;
+
+    // split transactions so that every partition gets about the same number of elements
+    std::vector<nova::task<Transactions>> tasks;
+    tasks.reserve(partition_num);
+    const auto *offsets = bin.get_offsets();
+    std::size_t bg = 0;
+    for (auto i = 0ul; i < partition_num; ++i) {
+        auto target = bin.elem_num() * (i + 1) / partition_num;
+        std::size_t ed = (i + 1 == partition_num)
+                                 ? bin.size()
+                                 : std::lower_bound(offsets + bg, offsets + bin.size(), target) - offsets;
+        tasks.emplace_back(loadBinaryRange(bin, bg, ed, i));
+        bg = ed;
+    }
+
+    if (is_debug_mode()) {
+        std::cerr << "binary database: " << bin.size() << " transactions, " << bin.elem_num() << " elements" << std::endl;
+        std::cerr << "# of loadBinaryRange tasks: " << tasks.size() << std::endl;
+    }
+
+    Database db(tasks.size());
+    std::size_t i = 0;
+    for (auto &&trans: co_await nova::when_all(std::move(tasks)))
+        db.get(i++) = std::move(trans);
+    co_return std::pair<Database, Item>{std::move(db), bin.max_item()};
+}
+
+auto DphimBase::loadBinaryRange(const BinaryDatabase &bin, std::size_t bg, std::size_t ed, int node) -> nova::task<Transactions> {
+
+    co_await schedule();
+
+    if (sched->get_current_node_id().has_value() && node > 0) {
+        while (sched->get_current_node_id().value() != node)
+            co_await schedule(node);
+    }
+
+    auto load_task = [](auto self, const BinaryDatabase &bin, std::size_t bg, std::size_t ed, int node) -> nova::task<Transactions> {
+        co_await self->schedule();
+        Transactions transactions;
+        transactions.reserve(ed - bg);
+        auto *twu = self->parsed_twu ? &self->parsed_twu->local() : nullptr;
+        for (auto i = bg; i < ed; ++i) {
+            Transaction tra;
+            self->reserveTransaction(tra, bin.transaction_size(i), node);
+            bin.fill(i, tra);
+            if (twu)
+                twu->add(tra);
+            transactions.push_back(std::move(tra));
+        }
+        co_return transactions;
+    };
+
+    constexpr std::size_t load_task_size = 4096;
+    std::vector<nova::task<Transactions>> tasks;
+    for (auto i = bg; i < ed; i += load_task_size)
+        tasks.emplace_back(load_task(this, bin, i, std::min(i + load_task_size, ed), node));
+
+    Transactions res;
+    res.reserve(ed - bg);
+    for (auto &&trans: co_await nova::when_all(std::move(tasks)))
+        res.append(std::move(trans));
+    co_return res;
 }
-}// namespace dphim
\ No newline at end of file
+}// namespace dphim
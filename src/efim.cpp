@@ -1,4 +1,6 @@
+#include <dphim/binary_database.hpp>
 #include <dphim/efim.hpp>
+#include <dphim/util/mapped_file.hpp>
 
 #include <fcntl.h>
 #include <sys/mman.h>
@@ -193,6 +195,28 @@ auto EFIM::searchXImpl(int j, const std::vector<Transaction> &transactionsOfP,
     Transaction previousTransaction{};
     int consecutive_merge_count = 0;
 
+    // for useHashMerging: merged transactions and the # of merges of each of them
+    MergeTable<Transaction> mergeTable;
+    std::vector<std::size_t> mergeCounts;
+
+    auto clone = [this](const Transaction &tra) {
+        if (pmem_alloc_type != PmemAllocType::None) {
+#ifdef DPHIM_PMEM
+            auto pmem_allocator = get_pmem_allocator();
+            return tra.clone(
+                    [=](auto size) { return pmem_allocator->alloc(size); },
+                    [=]([[maybe_unused]] auto size) {
+                        return [=](auto *p) {
+                            using T = std::remove_pointer_t<std::remove_cvref_t<decltype(p)>>;
+                            p->~T();
+                            pmem_allocator->dealloc(p);
+                        };
+                    });
+#endif
+        }
+        return tra.clone();
+    };
+
     for (auto &transaction: transactionsOfP) {
         auto iterX = std::lower_bound(
                 transaction.begin(), transaction.end(), Transaction::Elem{x, 0},
@@ -209,27 +233,21 @@ auto EFIM::searchXImpl(int j, const std::vector<Transaction> &transactionsOfP,
                 auto projected = transaction.projection(iterX);
                 utilityPx += projected.prefix_utility;
 
-                if (!previousTransaction) {
+                if (useHashMerging) {
+                    auto hash = projected.hash_extension();
+                    if (auto i = mergeTable.find(projected, hash)) {
+                        if (mergeCounts[*i]++ == 0)
+                            mergeTable[*i] = clone(mergeTable[*i]);
+                        mergeTable[*i].merge(projected);
+                    } else {
+                        mergeTable.add(std::move(projected), hash);
+                        mergeCounts.push_back(0);
+                    }
+                } else if (!previousTransaction) {
                     previousTransaction = std::move(projected);
                 } else if (projected.compare_extension(previousTransaction)) {
-                    if (consecutive_merge_count == 0) {
-                        if (pmem_alloc_type != PmemAllocType::None) {
-#ifdef DPHIM_PMEM
-                            auto pmem_allocator = get_pmem_allocator();
-                            previousTransaction = previousTransaction.clone(
-                                    [=](auto size) { return pmem_allocator->alloc(size); },
-                                    [=]([[maybe_unused]] auto size) {
-                                        return [=](auto *p) {
-                                            using T = std::remove_pointer_t<std::remove_cvref_t<decltype(p)>>;
-                                            p->~T();
-                                            pmem_allocator->dealloc(p);
-                                        };
-                                    });
-#endif
-                        } else {
-                            previousTransaction = previousTransaction.clone();
-                        }
-                    }
+                    if (consecutive_merge_count == 0)
+                        previousTransaction = clone(previousTransaction);
                     previousTransaction.merge(std::move(projected));
                     consecutive_merge_count++;
                 } else {
@@ -248,6 +266,8 @@ auto EFIM::searchXImpl(int j, const std::vector<Transaction> &transactionsOfP,
     if (previousTransaction) {
         transactionPx.push_back(std::move(previousTransaction));
     }
+    for (auto &tra: mergeTable.release())
+        transactionPx.push_back(std::move(tra));
 
     decltype(auto) UB = calcUpperBounds(transactionPx, j, itemsToKeep);
 
@@ -277,63 +297,32 @@ auto EFIM::searchXImpl(int j, const std::vector<Transaction> &transactionsOfP,
     };
 }
 
-std::pair<Transaction, Item> EFIM::parseTransactionOneLine(std::string line) {
-    Transaction tra;
-    Item max_item = 0;
-    try {
-        std::size_t i = 0, j = 0;
-        std::vector<std::pair<Item, Utility>> buf;
-        while (i < line.size()) {
-            try {
-                auto item = static_cast<Item>(std::stol(line.data() + i, &j));
-                max_item = std::max(max_item, item);
-                i += j + 1;
-                buf.push_back({item, 0});
-                if (line[i - 1] == ':')
-                    break;
-            } catch (std::invalid_argument &e) {
-                std::cerr << e.what() << ": " << __LINE__ << " " << line << std::endl;
-            }
-        }
-
-        if (pmem_alloc_type != PmemAllocType::None) {
+void EFIM::reserveTransaction(Transaction &tra, std::size_t n) {
+    if (pmem_alloc_type != PmemAllocType::None) {
 #ifdef DPHIM_PMEM
-            auto pmem_allocator = get_pmem_allocator();
-            tra.reserve(
-                    buf.size(),
-                    [=](auto size) { return pmem_allocator->alloc(size); },
-                    [=]([[maybe_unused]] auto size) {
-                        return [=](Transaction::Elem *p) {
-                            p->~pair();
-                            pmem_allocator->dealloc(p);
-                        };
-                    });
+        auto pmem_allocator = get_pmem_allocator();
+        tra.reserve(
+                n,
+                [=](auto size) { return pmem_allocator->alloc(size); },
+                [=]([[maybe_unused]] auto size) {
+                    return [=](Transaction::Elem *p) {
+                        p->~pair();
+                        pmem_allocator->dealloc(p);
+                    };
+                });
 #endif
-        } else {
-            tra.reserve(buf.size());
-        }
-
-        for (auto &&e: buf)
-            tra.push_back(std::move(e));
-
-        try {
-            tra.transaction_utility = static_cast<Utility>(std::stol(line.data() + i, &j));
-        } catch (std::invalid_argument &e) {
-            std::cerr << e.what() << ": " << __LINE__ << " " << line << std::endl;
-        }
-
-        i += j + 1;
-        if (line[i - 1] != ':')
-            throw std::runtime_error("failed to parse");
+    } else {
+        tra.reserve(n);
+    }
+}
 
-        for (auto &[item, util]: tra) {
-            try {
-                util = static_cast<Utility>(std::stol(line.data() + i, &j));
-                i += j + 1;
-            } catch (std::invalid_argument &e) {
-                std::cerr << e.what() << ": " << __LINE__ << " " << line << std::endl;
-            }
-        }
+std::pair<Transaction, Item> EFIM::parseTransactionOneLine(std::string_view line) {
+    Transaction tra;
+    Item max_item = 0;
+    try {
+        max_item = decodeTransaction(line, tra, [this](Transaction &t, std::size_t n) {
+            reserveTransaction(t, n);
+        });
     } catch (std::exception &e) {
         std::cerr << e.what() << std::endl;
         std::cerr << "input: " << line << std::endl;
@@ -343,38 +332,51 @@ std::pair<Transaction, Item> EFIM::parseTransactionOneLine(std::string line) {
 }
 
 std::pair<std::vector<Transaction>, Item> EFIM::parseTransactions(const std::string &input_path) {
-    int fd = open(input_path.c_str(), O_RDONLY);
-    if (fd == -1)
-        throw std::runtime_error(strerror(errno));
-
-    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
-
-    std::vector<std::string> lines;
-    {
-        std::string line;
-        constexpr std::size_t buf_size = 4092;
-        alignas(alignof(std::max_align_t)) char buf[buf_size];
-        while (auto bytes_read = read(fd, buf, buf_size)) {
-            if (bytes_read < 0)
-                throw std::runtime_error("read failed");
-
-            char *prev = buf, *p = nullptr;
-            for (; (p = (char *) memchr(prev, '\n', (buf + bytes_read) - prev)); prev = p + 1) {
-                line.insert(line.size(), prev, p - prev);
-                if (auto comment_pos = line.find_first_of("%#@"); comment_pos != std::string::npos)
-                    line.erase(comment_pos);
-                if (line.empty())
-                    continue;
-                lines.push_back(std::move(line));
-                line.clear();
-            }
-            line.insert(line.size(), prev, buf + buf_size - prev);
+    auto files = listInputFiles(input_path);
+    if (files.size() > 1) {
+        std::vector<Transaction> res;
+        Item maxItem = 0;
+        for (const auto &file: files) {
+            auto [transactions, mI] = parseTransactions(file);
+            std::move(transactions.begin(), transactions.end(), std::back_inserter(res));
+            maxItem = std::max(maxItem, mI);
+        }
+        return std::make_pair(std::move(res), maxItem);
+    }
+    // e.g. a directory with one file
+    if (files.front() != input_path)
+        return parseTransactions(files.front());
+
+    if (isBinaryDatabase(input_path)) {
+        BinaryDatabase bin(input_path);
+        std::vector<Transaction> res;
+        res.reserve(bin.size());
+        for (std::size_t i = 0; i < bin.size(); ++i) {
+            Transaction tra;
+            reserveTransaction(tra, bin.transaction_size(i));
+            bin.fill(i, tra);
+            res.push_back(std::move(tra));
         }
+        return std::make_pair(std::move(res), bin.max_item());
+    }
+
+    MappedFile file(input_path.c_str());
+
+    std::vector<std::string_view> lines;
+    for (const char *prev = file.begin(); prev < file.end();) {
+        const auto *p = static_cast<const char *>(memchr(prev, '\n', file.end() - prev));
+        if (!p)
+            p = file.end();
+        auto line = stripLine({prev, static_cast<std::size_t>(p - prev)});
+        prev = p + 1;
+        if (!line.empty())
+            lines.push_back(line);
     }
 
     std::vector<Transaction> res;
+    res.reserve(lines.size());
     Item maxItem = 0;
-    for (auto &&[tra, mI]: map_sp([this](std::string &&line) { return parseTransactionOneLine(std::move(line)); }, std::move(lines))) {
+    for (auto &&[tra, mI]: map_sp([this](std::string_view line) { return parseTransactionOneLine(line); }, lines)) {
         res.push_back(std::move(tra));
         maxItem = std::max(maxItem, mI);
     }
@@ -0,0 +1,148 @@
+#include <dphim/util/io_uring_reader.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace dphim {
+
+namespace {
+
+int io_uring_setup(unsigned entries, io_uring_params *p) {
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, p));
+}
+
+int io_uring_enter(int ring_fd, unsigned to_submit, unsigned min_complete, unsigned flags) {
+    return static_cast<int>(syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete, flags, nullptr, 0));
+}
+
+template<typename T>
+T *at(void *base, std::uint32_t offset) {
+    return reinterpret_cast<T *>(static_cast<char *>(base) + offset);
+}
+
+}// namespace
+
+bool IoUringReader::available() {
+    static const bool ret = [] {
+        io_uring_params p{};
+        int fd = io_uring_setup(1, &p);
+        if (fd < 0)
+            return false;
+        close(fd);
+        return true;
+    }();
+    return ret;
+}
+
+IoUringReader::IoUringReader(int fd, unsigned entries) : fd(fd) {
+    io_uring_params p{};
+    ring_fd = io_uring_setup(entries, &p);
+    if (ring_fd < 0)
+        throw std::runtime_error(std::string("io_uring_setup: ") + strerror(errno));
+
+    sq_ring_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    cq_ring_size = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+    bool single_mmap = p.features & IORING_FEAT_SINGLE_MMAP;
+    if (single_mmap)
+        sq_ring_size = cq_ring_size = std::max(sq_ring_size, cq_ring_size);
+
+    auto map = [this](std::size_t size, off_t offset) {
+        auto *ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, offset);
+        if (ptr == MAP_FAILED) {
+            auto err = errno;
+            release();
+            throw std::runtime_error(std::string("io_uring mmap: ") + strerror(err));
+        }
+        return ptr;
+    };
+    sq_ptr = map(sq_ring_size, IORING_OFF_SQ_RING);
+    cq_ptr = single_mmap ? sq_ptr : map(cq_ring_size, IORING_OFF_CQ_RING);
+    sqes_size = p.sq_entries * sizeof(io_uring_sqe);
+    sqes = static_cast<io_uring_sqe *>(map(sqes_size, IORING_OFF_SQES));
+
+    sq_tail = at<unsigned>(sq_ptr, p.sq_off.tail);
+    sq_mask = at<unsigned>(sq_ptr, p.sq_off.ring_mask);
+    sq_array = at<unsigned>(sq_ptr, p.sq_off.array);
+    cq_head = at<unsigned>(cq_ptr, p.cq_off.head);
+    cq_tail = at<unsigned>(cq_ptr, p.cq_off.tail);
+    cq_mask = at<unsigned>(cq_ptr, p.cq_off.ring_mask);
+    cqes = at<io_uring_cqe>(cq_ptr, p.cq_off.cqes);
+
+    iovecs = new iovec[p.sq_entries];
+}
+
+IoUringReader::~IoUringReader() {
+    // wait for in-flight reads, since their buffers are released by the caller after this
+    while (inflight > 0) {
+        if (!poll() && io_uring_enter(ring_fd, 0, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR)
+            break;
+    }
+    release();
+}
+
+void IoUringReader::release() noexcept {
+    if (sqes)
+        munmap(sqes, sqes_size);
+    if (cq_ptr && cq_ptr != sq_ptr)
+        munmap(cq_ptr, cq_ring_size);
+    if (sq_ptr)
+        munmap(sq_ptr, sq_ring_size);
+    if (ring_fd >= 0)
+        close(ring_fd);
+    delete[] iovecs;
+    sqes = nullptr;
+    sq_ptr = cq_ptr = nullptr;
+    ring_fd = -1;
+    iovecs = nullptr;
+}
+
+void IoUringReader::submit_read(void *buf, std::size_t len, off_t offset, std::uint64_t user_data) {
+    auto tail = std::atomic_ref(*sq_tail).load(std::memory_order_relaxed);
+    auto idx = tail & *sq_mask;
+
+    iovecs[idx] = iovec{buf, len};
+    auto *sqe = &sqes[idx];
+    std::memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = IORING_OP_READV;
+    sqe->fd = fd;
+    sqe->addr = reinterpret_cast<std::uint64_t>(&iovecs[idx]);
+    sqe->len = 1;
+    sqe->off = offset;
+    sqe->user_data = user_data;
+    sq_array[idx] = idx;
+    std::atomic_ref(*sq_tail).store(tail + 1, std::memory_order_release);
+
+    if (io_uring_enter(ring_fd, 1, 0, 0) < 0)
+        throw std::runtime_error(std::string("io_uring_enter: ") + strerror(errno));
+    inflight += 1;
+}
+
+std::optional<IoUringReader::Completion> IoUringReader::poll() {
+    auto head = std::atomic_ref(*cq_head).load(std::memory_order_relaxed);
+    if (head == std::atomic_ref(*cq_tail).load(std::memory_order_acquire))
+        return std::nullopt;
+    const auto &cqe = cqes[head & *cq_mask];
+    Completion ret{cqe.user_data, cqe.res};
+    std::atomic_ref(*cq_head).store(head + 1, std::memory_order_release);
+    inflight -= 1;
+    return ret;
+}
+
+IoUringReader::Completion IoUringReader::wait() {
+    while (true) {
+        if (auto c = poll())
+            return *c;
+        if (io_uring_enter(ring_fd, 0, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR)
+            throw std::runtime_error(std::string("io_uring_enter: ") + strerror(errno));
+    }
+}
+
+}// namespace dphim
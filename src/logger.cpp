@@ -63,19 +63,44 @@ ConcurrentLogger::ConcurrentLogger(const std::string &output_path, Utility min_u
 }
 
 void ConcurrentLogger::flushOutput() {
-    if (not output_is_null) {
-        for (auto &result: results) {
-            for (auto &[items, util]: result) {
-                for (auto i: items) {
-                    output << i << " ";
-                }
-                output << "#UTIL: " << util << std::endl;
+    auto write = [this](const std::list<std::pair<std::vector<Item>, Utility>> &result) {
+        for (auto &[items, util]: result) {
+            for (auto i: items) {
+                output << i << " ";
             }
+            output << "#UTIL: " << util << std::endl;
         }
+    };
+    if (not output_is_null) {
+        for (auto &section: sections) {
+            output << "#MINUTIL: " << section.min_util << std::endl;
+            write(section.results);
+        }
+        for (auto &result: results)
+            write(result);
+    }
+}
+
+void ConcurrentLogger::endSection(Utility min_util) {
+    Section section{min_util, hui_count.get(), candidate_count.get(), {}};
+    for (auto &prev: sections) {
+        section.hui_count -= prev.hui_count;
+        section.candidate_count -= prev.candidate_count;
     }
+    // the per-thread lists stay where the threads refer to them
+    for (auto &result: results)
+        section.results.splice(section.results.end(), result);
+    sections.push_back(std::move(section));
 }
 
 
+std::pair<std::size_t, std::size_t> ConcurrentLogger::headlineCounts() {
+    for (const auto &section: sections)
+        if (section.min_util == min_util)
+            return {section.hui_count, section.candidate_count};
+    return {hui_count.get(), candidate_count.get()};
+}
+
 void ConcurrentLogger::time_point(const std::string &name) {
     if (is_debug) {
         std::cerr << "time point: " << name << std::endl;
@@ -87,17 +112,24 @@ void ConcurrentLogger::print(std::ostream &out) {
     using namespace std::chrono;
     auto tot_time = duration_cast<milliseconds>(timer.totalTime()).count();
     auto cpu_time = duration_cast<milliseconds>(timer.totalCpuTime()).count();
+    auto [huis, candidates] = headlineCounts();
     out << "============= RESULT ===============\n";
     out << "minUtil = " << min_util << "\n";
-    out << "High utility itemsets count: " << hui_count.get() << "\n";
-    out << "Candidate count: " << candidate_count.get() << "\n";
+    out << "High utility itemsets count: " << huis << "\n";
+    out << "Candidate count: " << candidates << "\n";
     out << "# of threads: " << thread_num << "\n";
     out << "Total time ~: " << tot_time << " ms\n";
     out << "CPU time ~: " << cpu_time << " ms\n";
     out << "CPU Usage ~: " << 1.0 * cpu_time / tot_time << " \n";
+    for (auto &section: sections) {
+        out << "  minUtil = " << section.min_util << ": " << section.hui_count << " high utility itemsets, "
+            << section.candidate_count << " candidates\n";
+    }
     if (is_debug) {
         out << "Step3 Internal Malloc: " << malloc_log.get() / 1000 << "kB\n";
         out << "                  Avg: " << malloc_log.get() / malloc_count.get() << "B\n";
+        out << "Step3 Flatten: " << flatten_log.get() / 1000 << "kB (" << flatten_count.get() << " partitions)\n";
+        out << "Step3 Compaction: " << reclaim_log.get() / 1000 << "kB reclaimed (" << reclaim_count.get() << " databases)\n";
     }
     out << "=========== STATISITCS =============\n";
     timer.print(out, false);
@@ -110,15 +142,28 @@ void ConcurrentLogger::print_json(std::ostream &out) {
     auto cpu_time = duration_cast<milliseconds>(timer.totalCpuTime()).count();
     auto indent = "  ";
     ;
+    auto [huis, candidates] = headlineCounts();
     out << "{\n";
     out << "\"result\": {\n"
         << indent << "\"minUtil\": " << min_util << ",\n"
-        << indent << "\"hui_count\": " << hui_count.get() << ",\n"
-        << indent << "\"candidate_count\": " << candidate_count.get() << ",\n"
+        << indent << "\"hui_count\": " << huis << ",\n"
+        << indent << "\"candidate_count\": " << candidates << ",\n"
         << indent << "\"thread_num\": " << thread_num << ",\n"
         << indent << "\"total_time\": " << tot_time << ",\n"
         << indent << "\"cpu_time\": " << cpu_time << ",\n"
-        << indent << "\"cpu_usage\": " << 1.0 * cpu_time / tot_time << "\n"
+        << indent << "\"cpu_usage\": " << 1.0 * cpu_time / tot_time;
+    if (!sections.empty()) {
+        // the search time of each threshold is in "statistics" as "Search@${minUtil}"
+        out << ",\n"
+            << indent << "\"sweep\": [";
+        for (std::size_t i = 0; i < sections.size(); ++i) {
+            out << (i ? ", " : "") << "{\"minUtil\": " << sections[i].min_util
+                << ", \"hui_count\": " << sections[i].hui_count
+                << ", \"candidate_count\": " << sections[i].candidate_count << "}";
+        }
+        out << "]";
+    }
+    out << "\n"
         << "},\n";
     out << "\"statistics\": ";
     timer.print(out, true);
@@ -1,61 +1,57 @@
+#include <dphim/binary_database.hpp>
 #include <dphim/parse.hpp>
+#include <dphim/tokenizer.hpp>
+#include <dphim/util/mapped_file.hpp>
 
-#include <cerrno>
 #include <cstddef>
 #include <cstring>
-#include <fcntl.h>
-#include <sys/stat.h>
-#include <unistd.h>
 
+#include <algorithm>
+#include <filesystem>
 #include <iostream>
+#include <iterator>
+#include <sstream>
 #include <string>
 
 namespace dphim {
 
-std::pair<Transaction, Item> parseTransactionOneLine(std::string line) {
-    Transaction tra;
-    Item max_item = 0;
-    try {
-        std::size_t i = 0, j = 0;
-        std::vector<std::pair<Item, Utility>> buf;
-        while (i < line.size()) {
-            try {
-                auto item = static_cast<Item>(std::stol(line.data() + i, &j));
-                max_item = std::max(max_item, item);
-                i += j + 1;
-                buf.emplace_back(item, 0);
-                if (line[i - 1] == ':')
-                    break;
-            } catch (std::invalid_argument &e) {
-                std::cerr << e.what() << ": " << __LINE__ << " " << line << std::endl;
-                throw e;
-            }
-        }
-
-        tra.reserve(buf.size());
-
-        for (auto &&e: buf)
-            tra.push_back(std::move(e));
-
-        try {
-            tra.transaction_utility = static_cast<Utility>(std::stol(line.data() + i, &j));
-        } catch (std::invalid_argument &e) {
-            std::cerr << e.what() << ": " << __LINE__ << " " << line << std::endl;
-            throw e;
+std::vector<std::string> listInputFiles(const std::string &input) {
+    std::vector<std::string> files;
+    std::stringstream ss(input);
+    std::string path;
+    while (std::getline(ss, path, ',')) {
+        if (path.empty())
+            continue;
+        if (std::filesystem::is_directory(path)) {
+            std::vector<std::string> dir_files;
+            for (const auto &entry: std::filesystem::directory_iterator(path))
+                if (entry.is_regular_file() && !entry.path().filename().string().starts_with('.'))
+                    dir_files.push_back(entry.path().string());
+            std::sort(dir_files.begin(), dir_files.end());
+            files.insert(files.end(), dir_files.begin(), dir_files.end());
+        } else {
+            files.push_back(path);
         }
+    }
+    if (files.empty())
+        throw std::runtime_error("no input file: " + input);
+    return files;
+}
 
-        i += j + 1;
-        if (line[i - 1] != ':')
-            throw std::runtime_error("failed to parse");
+std::pair<std::vector<Transaction>, Item> loadBinaryDatabase(const std::string &input_path) {
+    BinaryDatabase bin(input_path);
+    std::vector<Transaction> res;
+    res.reserve(bin.size());
+    for (std::size_t i = 0; i < bin.size(); ++i)
+        res.push_back(bin.get(i));
+    return std::make_pair(std::move(res), bin.max_item());
+}
 
-        for (auto &[item, util]: tra) {
-            try {
-                util = static_cast<Utility>(std::stol(line.data() + i, &j));
-                i += j + 1;
-            } catch (std::invalid_argument &e) {
-                std::cerr << e.what() << ": " << __LINE__ << " " << line << std::endl;
-            }
-        }
+std::pair<Transaction, Item> parseTransactionOneLine(std::string_view line) {
+    Transaction tra;
+    Item max_item = 0;
+    try {
+        max_item = decodeTransaction(line, tra, [](Transaction &t, std::size_t n) { t.reserve(n); });
     } catch (std::exception &e) {
         std::cerr << e.what() << std::endl;
         std::cerr << "input: " << line << std::endl;
@@ -65,45 +61,52 @@ std::pair<Transaction, Item> parseTransactionOneLine(std::string line) {
 }
 
 std::pair<std::vector<Transaction>, Item> parseTransactions(const std::string &input_path) {
-    const int fd = open(input_path.c_str(), O_RDONLY);
-    if (fd == -1)
-        throw std::runtime_error(strerror(errno));
+    auto files = listInputFiles(input_path);
+    if (files.size() > 1) {
+        std::vector<Transaction> res;
+        Item maxItem = 0;
+        for (const auto &file: files) {
+            auto [transactions, mI] = parseTransactions(file);
+            std::move(transactions.begin(), transactions.end(), std::back_inserter(res));
+            maxItem = std::max(maxItem, mI);
+        }
+        return std::make_pair(std::move(res), maxItem);
+    }
+    // e.g. a directory with one file
+    if (files.front() != input_path)
+        return parseTransactions(files.front());
 
-    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    if (isBinaryDatabase(input_path))
+        return loadBinaryDatabase(input_path);
+
+    MappedFile file(input_path.c_str());
 
-    constexpr std::size_t buf_size = 4092;
-    alignas(alignof(std::max_align_t)) char buf[buf_size];
-    std::string line;
     std::vector<Transaction> res;
     Item maxItem = 0;
-    while (auto bytes_read = read(fd, buf, buf_size)) {
-        if (bytes_read < 0)
-            throw std::runtime_error("read failed");
-
-        char *prev = buf, *p = nullptr;
-        for (; (p = (char *) memchr(prev, '\n', (buf + bytes_read) - prev)); prev = p + 1) {
-            line.insert(line.size(), prev, p - prev);
-
-            if (auto comment_pos = line.find_first_of("%#@"); comment_pos != std::string::npos)
-                line.erase(comment_pos);
-            if (line.empty())
-                continue;
-
-            auto [tra, mI] = parseTransactionOneLine(std::move(line));
-            line.clear();
+    TokenizedLines tl;
+    // tokenize in chunks so that offsets fit in 32 bits
+    constexpr std::size_t chunk_size = 1ul << 30;
+    for (const char *bg = file.begin(); bg < file.end();) {
+        const char *ed = file.end();
+        if (static_cast<std::size_t>(ed - bg) > chunk_size) {
+            ed = static_cast<const char *>(std::memchr(bg + chunk_size, '\n', file.end() - bg - chunk_size));
+            ed = ed ? ed + 1 : file.end();
+        }
+        tokenizeLines(bg, ed, tl);
+        for (const auto &line: tl.lines) {
+            Transaction tra;
+            try {
+                maxItem = std::max(maxItem, decodeTokenizedTransaction(tl, line, ed, tra, [](Transaction &t, std::size_t n) { t.reserve(n); }));
+            } catch (std::exception &e) {
+                std::cerr << e.what() << std::endl;
+                std::cerr << "input: " << tl.line(line) << std::endl;
+                throw;
+            }
             res.push_back(std::move(tra));
-            maxItem = std::max(maxItem, mI);
         }
-        line.insert(line.size(), prev, buf + buf_size - prev);
-    }
-
-    {
-        auto [tra, mI] = parseTransactionOneLine(std::move(line));
-        line.clear();
-        res.push_back(std::move(tra));
-        maxItem = std::max(maxItem, mI);
+        bg = ed;
     }
 
     return std::make_pair(std::move(res), maxItem);
 }
-}// namespace dphim
\ No newline at end of file
+}// namespace dphim
@@ -0,0 +1,194 @@
+#include <dphim/parse.hpp>
+#include <dphim/snapshot.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+#include <sys/stat.h>
+
+namespace dphim {
+
+namespace {
+
+struct InputKey {
+    std::string path;
+    std::uint64_t size;
+    std::int64_t mtime;
+};
+
+// for multiple input files: the joined paths, the total size and the latest modification time
+InputKey getInputKey(const std::string &input_path) {
+    InputKey key{"", 0, 0};
+    for (const auto &file: listInputFiles(input_path)) {
+        struct stat st;
+        if (stat(file.c_str(), &st) == -1)
+            throw std::runtime_error(file + ": " + strerror(errno));
+        if (!key.path.empty())
+            key.path += ',';
+        key.path += std::filesystem::canonical(file).string();
+        key.size += st.st_size;
+        key.mtime = std::max<std::int64_t>(key.mtime, static_cast<std::int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec);
+    }
+    return key;
+}
+
+// FNV-1a, so that file names do not depend on the standard library implementation
+std::uint64_t hashPath(const std::string &path) {
+    std::uint64_t h = 14695981039346656037ull;
+    for (unsigned char c: path) {
+        h ^= c;
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+template<typename T>
+void writeValue(std::ostream &out, const T &v) {
+    out.write(reinterpret_cast<const char *>(&v), sizeof(v));
+}
+
+template<typename T>
+void writeVector(std::ostream &out, const std::vector<T> &v) {
+    writeValue(out, static_cast<std::uint64_t>(v.size()));
+    out.write(reinterpret_cast<const char *>(v.data()), sizeof(T) * v.size());
+}
+
+template<typename T>
+void readValue(std::istream &in, T &v) {
+    in.read(reinterpret_cast<char *>(&v), sizeof(v));
+}
+
+// fails `in` without allocating if the rest of the stream is too short for the vector (e.g. a damaged snapshot)
+template<typename T>
+void readVector(std::istream &in, std::vector<T> &v) {
+    std::uint64_t n = 0;
+    readValue(in, n);
+    auto pos = in.tellg();
+    in.seekg(0, std::ios::end);
+    auto end = in.tellg();
+    in.seekg(pos);
+    if (!in || n > static_cast<std::uint64_t>(end - pos) / sizeof(T)) {
+        in.setstate(std::ios::failbit);
+        return;
+    }
+    v.resize(n);
+    in.read(reinterpret_cast<char *>(v.data()), sizeof(T) * n);
+}
+
+}// namespace
+
+std::string Snapshot::prefix(const std::string &snapshot_dir, const std::string &canonical_path) {
+    std::ostringstream ss;
+    ss << std::filesystem::path(canonical_path).filename().string() << '-'
+       << std::hex << std::setw(16) << std::setfill('0') << hashPath(canonical_path);
+    return (std::filesystem::path(snapshot_dir) / ss.str()).string();
+}
+
+std::string Snapshot::base_path(const std::string &prefix, Utility min_util, bool merge_duplicates) {
+    return prefix + ".m" + std::to_string(min_util) + (merge_duplicates ? "" : ".nomerge");
+}
+
+std::optional<Snapshot> Snapshot::find(const std::string &snapshot_dir, const std::string &input_path, Utility min_util,
+                                       bool merge_duplicates) {
+    if (!std::filesystem::is_directory(snapshot_dir))
+        return std::nullopt;
+
+    auto key = getInputKey(input_path);
+    auto pre = std::filesystem::path(prefix(snapshot_dir, key.path)).filename().string() + ".m";
+
+    std::optional<Snapshot> best;
+    std::string best_path;
+    for (const auto &entry: std::filesystem::directory_iterator(snapshot_dir)) {
+        auto name = entry.path().filename().string();
+        if (!name.starts_with(pre) || !name.ends_with(".meta"))
+            continue;
+        auto snap = load(entry.path().string(), true);
+        if (!snap || snap->input_path != key.path || snap->input_size != key.size || snap->input_mtime != key.mtime)
+            continue;// stale or broken snapshot
+        if (snap->merge_duplicates != merge_duplicates)
+            continue;
+        if (snap->min_util > min_util || (best && best->min_util >= snap->min_util))
+            continue;
+        best = std::move(snap);
+        best_path = entry.path().string();
+    }
+    if (!best)
+        return std::nullopt;
+    return load(best_path, false);
+}
+
+Snapshot Snapshot::make(const std::string &snapshot_dir, const std::string &input_path, Utility min_util,
+                        bool merge_duplicates) {
+    std::filesystem::create_directories(snapshot_dir);
+    auto key = getInputKey(input_path);
+    Snapshot snap;
+    snap.input_path = key.path;
+    snap.input_size = key.size;
+    snap.input_mtime = key.mtime;
+    snap.min_util = min_util;
+    snap.merge_duplicates = merge_duplicates;
+    snap.database_path = base_path(prefix(snapshot_dir, key.path), min_util, merge_duplicates) + ".db";
+    return snap;
+}
+
+void Snapshot::save(const std::string &snapshot_dir) const {
+    auto path = base_path(prefix(snapshot_dir, input_path), min_util, merge_duplicates) + ".meta";
+    auto tmp_path = path + ".tmp";
+    {
+        std::ofstream out(tmp_path, std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!out)
+            throw std::runtime_error("failed to open snapshot (" + tmp_path + ")");
+        out.write(magic_value, sizeof(magic_value));
+        writeValue(out, current_version);
+        writeValue(out, input_size);
+        writeValue(out, input_mtime);
+        writeValue(out, min_util);
+        writeValue(out, static_cast<std::uint8_t>(merge_duplicates));
+        writeVector(out, std::vector<char>(input_path.begin(), input_path.end()));
+        writeVector(out, newNameToOldNames);
+        writeVector(out, TWU);
+        writeVector(out, SU);
+        if (!out)
+            throw std::runtime_error("failed to write snapshot (" + tmp_path + ")");
+    }
+    std::filesystem::rename(tmp_path, path);
+}
+
+std::optional<Snapshot> Snapshot::load(const std::string &meta_path, bool header_only) {
+    std::ifstream in(meta_path, std::ios::in | std::ios::binary);
+    char magic[sizeof(magic_value)] = {};
+    std::uint32_t version = 0;
+    in.read(magic, sizeof(magic));
+    readValue(in, version);
+    if (!in || std::memcmp(magic, magic_value, sizeof(magic)) != 0 || version != current_version)
+        return std::nullopt;
+
+    Snapshot snap;
+    std::vector<char> path;
+    readValue(in, snap.input_size);
+    readValue(in, snap.input_mtime);
+    readValue(in, snap.min_util);
+    std::uint8_t merge = 1;
+    readValue(in, merge);
+    snap.merge_duplicates = merge != 0;
+    readVector(in, path);
+    snap.input_path.assign(path.begin(), path.end());
+    if (!header_only) {
+        readVector(in, snap.newNameToOldNames);
+        readVector(in, snap.TWU);
+        readVector(in, snap.SU);
+    }
+    if (!in)
+        return std::nullopt;
+
+    snap.database_path = meta_path.substr(0, meta_path.size() - std::string(".meta").size()) + ".db";
+    return snap;
+}
+
+}// namespace dphim
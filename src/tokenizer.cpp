@@ -0,0 +1,193 @@
+#include <dphim/tokenizer.hpp>
+
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define DPHIM_TOKENIZER_X86
+#endif
+
+namespace dphim {
+
+namespace {
+
+ByteMasks classifyScalar(const char *block) {
+    ByteMasks m{0, 0, 0, 0};
+    for (int i = 0; i < 64; ++i) {
+        auto c = block[i];
+        auto bit = std::uint64_t(1) << i;
+        m.newline |= c == '\n' ? bit : 0;
+        m.colon |= c == ':' ? bit : 0;
+        m.comment |= (c == '%' || c == '#' || c == '@') ? bit : 0;
+        m.digit |= static_cast<unsigned char>(c - '0') < 10 ? bit : 0;
+    }
+    return m;
+}
+
+#ifdef DPHIM_TOKENIZER_X86
+
+__attribute__((target("avx2"))) inline std::uint64_t movemask64(__m256i lo, __m256i hi) {
+    return std::uint64_t(std::uint32_t(_mm256_movemask_epi8(lo))) | (std::uint64_t(std::uint32_t(_mm256_movemask_epi8(hi))) << 32);
+}
+
+__attribute__((target("avx2"))) inline std::uint64_t eq64(__m256i lo, __m256i hi, char c) {
+    auto v = _mm256_set1_epi8(c);
+    return movemask64(_mm256_cmpeq_epi8(lo, v), _mm256_cmpeq_epi8(hi, v));
+}
+
+// (c - '0') <= 9 as unsigned bytes
+__attribute__((target("avx2"))) inline __m256i isDigit256(__m256i v) {
+    auto d = _mm256_sub_epi8(v, _mm256_set1_epi8('0'));
+    return _mm256_cmpeq_epi8(_mm256_min_epu8(d, _mm256_set1_epi8(9)), d);
+}
+
+__attribute__((target("avx2"))) ByteMasks classifyAVX2(const char *block) {
+    auto lo = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(block));
+    auto hi = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(block + 32));
+    return ByteMasks{
+            eq64(lo, hi, '\n'),
+            eq64(lo, hi, ':'),
+            eq64(lo, hi, '%') | eq64(lo, hi, '#') | eq64(lo, hi, '@'),
+            movemask64(isDigit256(lo), isDigit256(hi)),
+    };
+}
+
+__attribute__((target("sse4.2"))) inline std::uint64_t movemask64(__m128i v0, __m128i v1, __m128i v2, __m128i v3) {
+    return std::uint64_t(std::uint16_t(_mm_movemask_epi8(v0))) |
+           (std::uint64_t(std::uint16_t(_mm_movemask_epi8(v1))) << 16) |
+           (std::uint64_t(std::uint16_t(_mm_movemask_epi8(v2))) << 32) |
+           (std::uint64_t(std::uint16_t(_mm_movemask_epi8(v3))) << 48);
+}
+
+__attribute__((target("sse4.2"))) inline std::uint64_t eq64(const __m128i (&v)[4], char c) {
+    auto s = _mm_set1_epi8(c);
+    return movemask64(_mm_cmpeq_epi8(v[0], s), _mm_cmpeq_epi8(v[1], s), _mm_cmpeq_epi8(v[2], s), _mm_cmpeq_epi8(v[3], s));
+}
+
+__attribute__((target("sse4.2"))) inline __m128i isDigit128(__m128i v) {
+    auto d = _mm_sub_epi8(v, _mm_set1_epi8('0'));
+    return _mm_cmpeq_epi8(_mm_min_epu8(d, _mm_set1_epi8(9)), d);
+}
+
+__attribute__((target("sse4.2"))) ByteMasks classifySSE42(const char *block) {
+    __m128i v[4];
+    for (int i = 0; i < 4; ++i)
+        v[i] = _mm_loadu_si128(reinterpret_cast<const __m128i *>(block + 16 * i));
+    return ByteMasks{
+            eq64(v, '\n'),
+            eq64(v, ':'),
+            eq64(v, '%') | eq64(v, '#') | eq64(v, '@'),
+            movemask64(isDigit128(v[0]), isDigit128(v[1]), isDigit128(v[2]), isDigit128(v[3])),
+    };
+}
+
+#endif
+
+}// namespace
+
+ClassifyBlockFn getClassifyBlock() {
+    static const ClassifyBlockFn fn = [] {
+#ifdef DPHIM_TOKENIZER_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2"))
+            return &classifyAVX2;
+        if (__builtin_cpu_supports("sse4.2"))
+            return &classifySSE42;
+#endif
+        return &classifyScalar;
+    }();
+    return fn;
+}
+
+ClassifyBlockFn getClassifyBlock(const std::string &isa) {
+    if (isa == "scalar")
+        return &classifyScalar;
+#ifdef DPHIM_TOKENIZER_X86
+    if (isa == "avx2" && __builtin_cpu_supports("avx2"))
+        return &classifyAVX2;
+    if (isa == "sse4.2" && __builtin_cpu_supports("sse4.2"))
+        return &classifySSE42;
+#endif
+    throw std::runtime_error("unsupported tokenizer: " + isa);
+}
+
+const char *getClassifyBlockName(ClassifyBlockFn fn) {
+#ifdef DPHIM_TOKENIZER_X86
+    if (fn == &classifyAVX2)
+        return "avx2";
+    if (fn == &classifySSE42)
+        return "sse4.2";
+#endif
+    return fn == &classifyScalar ? "scalar" : "unknown";
+}
+
+void tokenizeLines(const char *bg, const char *ed, TokenizedLines &out, ClassifyBlockFn classify) {
+    out.base = bg;
+    out.starts.clear();
+    out.lines.clear();
+
+    const auto len = static_cast<std::uint32_t>(ed - bg);
+    TokenizedLine cur{0, 0, 0, 0, 0, 0, 0};
+    bool in_comment = false;
+    std::uint64_t prev_digit = 0;// 1 if the last byte of the previous block is a digit
+
+    // drop the events before the next newline
+    auto skip_comment = [](std::uint64_t events, std::uint64_t newline) {
+        auto nl = events & newline;
+        return nl ? events & ~((nl & -nl) - 1) : 0;
+    };
+
+    auto finish_line = [&](std::uint32_t line_ed) {
+        if (cur.field_num > 0) {
+            cur.line_ed = line_ed;
+            out.lines.push_back(cur);
+        }
+        cur = TokenizedLine{static_cast<std::uint32_t>(out.starts.size()), 0, 0, 0, 0, line_ed + 1, 0};
+        in_comment = false;
+    };
+
+    for (std::uint32_t off = 0; off < len; off += 64) {
+        ByteMasks m;
+        if (len - off >= 64) {
+            m = classify(bg + off);
+        } else {
+            char buf[64];
+            std::memset(buf, ' ', sizeof(buf));
+            std::memcpy(buf, bg + off, len - off);
+            m = classify(buf);
+        }
+        auto start = m.digit & ~((m.digit << 1) | prev_digit);
+        prev_digit = m.digit >> 63;
+
+        // events are visited in the order of their positions
+        auto events = start | m.newline | m.colon | m.comment;
+        if (in_comment)
+            events = skip_comment(events, m.newline);
+        while (events) {
+            auto b = __builtin_ctzll(events);
+            auto bit = std::uint64_t(1) << b;
+            auto pos = off + b;
+            events &= events - 1;
+
+            if (m.newline & bit) {
+                finish_line(pos);
+            } else if (m.comment & bit) {
+                // skip until the end of the line
+                in_comment = true;
+                events = skip_comment(events, m.newline);
+            } else if (m.colon & bit) {
+                if (cur.colon_num == 0)
+                    cur.before_colon1 = cur.field_num;
+                else if (cur.colon_num == 1)
+                    cur.before_colon2 = cur.field_num;
+                cur.colon_num = std::min<std::uint32_t>(cur.colon_num + 1, 2);
+            } else {
+                out.starts.push_back(pos);
+                cur.field_num += 1;
+            }
+        }
+    }
+    finish_line(len);
+}
+
+}// namespace dphim
@@ -0,0 +1,239 @@
+#include <dphim/utility_bin_array.hpp>
+
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <stdexcept>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define DPHIM_UTILITY_BIN_ARRAY_X86
+#endif
+
+namespace dphim {
+
+namespace {
+
+template<typename U>
+void addScalar(U *dst, const U *src, std::size_t n) {
+    for (std::size_t i = 0; i < n; ++i)
+        dst[i] += src[i];
+}
+
+// branchless: every item is stored and the output is advanced only if it is selected
+template<typename U>
+std::pair<std::size_t, std::size_t> selectScalar(const Item *items, std::size_t n, Item offset, const U *bins,
+                                                 U min_util, Item *newK, Item *newE) {
+    std::size_t k = 0, e = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+        auto item = items[i];
+        auto lu = bins[2 * (item - offset)], su = bins[2 * (item - offset) + 1];
+        bool explore = su >= min_util;
+        newK[k] = item;
+        newE[e] = item;
+        k += explore | (lu >= min_util);
+        e += explore;
+    }
+    return {k, e};
+}
+
+#ifdef DPHIM_UTILITY_BIN_ARRAY_X86
+
+// gathers pay off only for long lists of items (shallow search nodes); deeper ones have a few items to select
+constexpr std::size_t simd_select_min_items = 64;
+
+// indices of the set bits of an 8-bit mask, one byte each, for compress-stores by permutation (AVX2 has none)
+constexpr auto compress_table = [] {
+    std::array<std::uint64_t, 256> table{};
+    for (unsigned mask = 0; mask < 256; ++mask) {
+        unsigned k = 0;
+        for (unsigned i = 0; i < 8; ++i)
+            if (mask & (1u << i))
+                table[mask] |= std::uint64_t(i) << (8 * k++);
+    }
+    return table;
+}();
+
+__attribute__((target("avx2"))) inline void compressStore8(Item *out, __m256i items, unsigned mask) {
+    auto perm = _mm256_cvtepu8_epi32(_mm_cvtsi64_si128(static_cast<long long>(compress_table[mask])));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(out), _mm256_permutevar8x32_epi32(items, perm));
+}
+
+// 4 lanes of `v` >= `min`, as 64-bit lane masks (AVX2 compares only signed integers)
+__attribute__((target("avx2"))) inline __m256i cmpgeEpu64(__m256i v, __m256i min) {
+    auto sign = _mm256_set1_epi64x(std::numeric_limits<long long>::min());
+    return _mm256_xor_si256(_mm256_cmpgt_epi64(_mm256_xor_si256(min, sign), _mm256_xor_si256(v, sign)),
+                            _mm256_set1_epi64x(-1));
+}
+
+// lane masks of 4 + 4 64-bit lanes to 8 bits
+__attribute__((target("avx2"))) inline unsigned movemask8(__m256i lo, __m256i hi) {
+    return unsigned(_mm256_movemask_pd(_mm256_castsi256_pd(lo))) |
+           unsigned(_mm256_movemask_pd(_mm256_castsi256_pd(hi))) << 4;
+}
+
+__attribute__((target("avx2"))) inline __m256i cmpgeEpu32(__m256i v, __m256i min) {
+    return _mm256_cmpeq_epi32(_mm256_max_epu32(v, min), v);
+}
+
+template<typename U>
+__attribute__((target("avx2"))) void addAVX2(U *dst, const U *src, std::size_t n) {
+    constexpr std::size_t lanes = 32 / sizeof(U);
+    std::size_t i = 0;
+    for (; i + lanes <= n; i += lanes) {
+        auto d = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(dst + i));
+        auto s = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+        auto sum = sizeof(U) == 8 ? _mm256_add_epi64(d, s) : _mm256_add_epi32(d, s);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), sum);
+    }
+    addScalar(dst + i, src + i, n - i);
+}
+
+// 8 items at a time: gather their utilities, compare them with min_util and compress-store the selected items
+// (the stores never pass items[i + 8] in the outputs, since at most i items have been selected before)
+template<typename U>
+__attribute__((target("avx2"))) std::pair<std::size_t, std::size_t>
+selectAVX2(const Item *items, std::size_t n, Item offset, const U *bins, U min_util, Item *newK,
+           Item *newE) {
+    if (n < simd_select_min_items)
+        return selectScalar(items, n, offset, bins, min_util, newK, newE);
+    std::size_t i = 0, k = 0, e = 0;
+    auto off = _mm256_set1_epi32(static_cast<int>(offset));
+    for (; i + 8 <= n; i += 8) {
+        auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(items + i));
+        auto idx = _mm256_slli_epi32(_mm256_sub_epi32(v, off), 1);
+        unsigned keep, explore;
+        if constexpr (sizeof(U) == 8) {
+            auto min = _mm256_set1_epi64x(static_cast<long long>(min_util));
+            auto lu = reinterpret_cast<const long long *>(bins);
+            auto su = reinterpret_cast<const long long *>(bins + 1);
+            auto lo = _mm256_castsi256_si128(idx), hi = _mm256_extracti128_si256(idx, 1);
+            auto lu_lo = cmpgeEpu64(_mm256_i32gather_epi64(lu, lo, 8), min);
+            auto lu_hi = cmpgeEpu64(_mm256_i32gather_epi64(lu, hi, 8), min);
+            auto su_lo = cmpgeEpu64(_mm256_i32gather_epi64(su, lo, 8), min);
+            auto su_hi = cmpgeEpu64(_mm256_i32gather_epi64(su, hi, 8), min);
+            explore = movemask8(su_lo, su_hi);
+            keep = movemask8(lu_lo, lu_hi) | explore;
+        } else {
+            auto min = _mm256_set1_epi32(static_cast<int>(min_util));
+            auto lu = cmpgeEpu32(_mm256_i32gather_epi32(reinterpret_cast<const int *>(bins), idx, 4), min);
+            auto su = cmpgeEpu32(_mm256_i32gather_epi32(reinterpret_cast<const int *>(bins + 1), idx, 4), min);
+            explore = _mm256_movemask_ps(_mm256_castsi256_ps(su));
+            keep = _mm256_movemask_ps(_mm256_castsi256_ps(lu)) | explore;
+        }
+        compressStore8(newK + k, v, keep);
+        compressStore8(newE + e, v, explore);
+        k += std::popcount(keep);
+        e += std::popcount(explore);
+    }
+    auto [tk, te] = selectScalar(items + i, n - i, offset, bins, min_util, newK + k, newE + e);
+    return {k + tk, e + te};
+}
+
+// gathers of 8 64-bit / 16 32-bit values (masked ones, whose source is not left undefined)
+__attribute__((target("avx512f"))) inline __m512i gather8(const void *base, __m256i idx) {
+    return _mm512_mask_i32gather_epi64(_mm512_setzero_si512(), 0xff, idx, base, 8);
+}
+
+__attribute__((target("avx512f"))) inline __m512i gather16(const void *base, __m512i idx) {
+    return _mm512_mask_i32gather_epi32(_mm512_setzero_si512(), 0xffff, idx, base, 4);
+}
+
+template<typename U>
+__attribute__((target("avx512f"))) void addAVX512(U *dst, const U *src, std::size_t n) {
+    constexpr std::size_t lanes = 64 / sizeof(U);
+    std::size_t i = 0;
+    for (; i + lanes <= n; i += lanes) {
+        auto d = _mm512_loadu_si512(dst + i);
+        auto s = _mm512_loadu_si512(src + i);
+        _mm512_storeu_si512(dst + i, sizeof(U) == 8 ? _mm512_add_epi64(d, s) : _mm512_add_epi32(d, s));
+    }
+    addScalar(dst + i, src + i, n - i);
+}
+
+template<typename U>
+__attribute__((target("avx512f,avx512vl"))) std::pair<std::size_t, std::size_t>
+selectAVX512(const Item *items, std::size_t n, Item offset, const U *bins, U min_util, Item *newK,
+             Item *newE) {
+    if (n < simd_select_min_items)
+        return selectScalar(items, n, offset, bins, min_util, newK, newE);
+    std::size_t i = 0, k = 0, e = 0;
+    if constexpr (sizeof(U) == 8) {
+        auto off = _mm256_set1_epi32(static_cast<int>(offset));
+        auto min = _mm512_set1_epi64(static_cast<long long>(min_util));
+        for (; i + 8 <= n; i += 8) {
+            auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(items + i));
+            auto idx = _mm256_slli_epi32(_mm256_sub_epi32(v, off), 1);
+            auto explore = _mm512_cmpge_epu64_mask(gather8(bins + 1, idx), min);
+            auto keep = _mm512_cmpge_epu64_mask(gather8(bins, idx), min) | explore;
+            _mm256_mask_compressstoreu_epi32(newK + k, keep, v);
+            _mm256_mask_compressstoreu_epi32(newE + e, explore, v);
+            k += std::popcount(unsigned(keep));
+            e += std::popcount(unsigned(explore));
+        }
+    } else {
+        auto off = _mm512_set1_epi32(static_cast<int>(offset));
+        auto min = _mm512_set1_epi32(static_cast<int>(min_util));
+        for (; i + 16 <= n; i += 16) {
+            auto v = _mm512_loadu_si512(items + i);
+            auto idx = _mm512_sub_epi32(v, off);
+            idx = _mm512_add_epi32(idx, idx);
+            auto explore = _mm512_cmpge_epu32_mask(gather16(bins + 1, idx), min);
+            auto keep = _mm512_cmpge_epu32_mask(gather16(bins, idx), min) | explore;
+            _mm512_mask_compressstoreu_epi32(newK + k, keep, v);
+            _mm512_mask_compressstoreu_epi32(newE + e, explore, v);
+            k += std::popcount(unsigned(keep));
+            e += std::popcount(unsigned(explore));
+        }
+    }
+    auto [tk, te] = selectScalar(items + i, n - i, offset, bins, min_util, newK + k, newE + e);
+    return {k + tk, e + te};
+}
+
+#endif
+
+template<typename U>
+constexpr UtilityBinArrayKernels<U> scalar_kernels{&addScalar<U>, &selectScalar<U>, "scalar"};
+#ifdef DPHIM_UTILITY_BIN_ARRAY_X86
+template<typename U>
+constexpr UtilityBinArrayKernels<U> avx2_kernels{&addAVX2<U>, &selectAVX2<U>, "avx2"};
+template<typename U>
+constexpr UtilityBinArrayKernels<U> avx512_kernels{&addAVX512<U>, &selectAVX512<U>, "avx512"};
+#endif
+
+}// namespace
+
+template<typename U>
+const UtilityBinArrayKernels<U> &getUtilityBinArrayKernels() {
+    static const UtilityBinArrayKernels<U> &kernels = []() -> const UtilityBinArrayKernels<U> & {
+#ifdef DPHIM_UTILITY_BIN_ARRAY_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512vl"))
+            return avx512_kernels<U>;
+        if (__builtin_cpu_supports("avx2"))
+            return avx2_kernels<U>;
+#endif
+        return scalar_kernels<U>;
+    }();
+    return kernels;
+}
+
+template<typename U>
+const UtilityBinArrayKernels<U> &getUtilityBinArrayKernels(const std::string &isa) {
+    if (isa == "scalar")
+        return scalar_kernels<U>;
+#ifdef DPHIM_UTILITY_BIN_ARRAY_X86
+    if (isa == "avx512" && __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512vl"))
+        return avx512_kernels<U>;
+    if (isa == "avx2" && __builtin_cpu_supports("avx2"))
+        return avx2_kernels<U>;
+#endif
+    throw std::runtime_error("unsupported utility bin array kernels: " + isa);
+}
+
+template const UtilityBinArrayKernels<std::uint32_t> &getUtilityBinArrayKernels();
+template const UtilityBinArrayKernels<std::uint64_t> &getUtilityBinArrayKernels();
+template const UtilityBinArrayKernels<std::uint32_t> &getUtilityBinArrayKernels(const std::string &isa);
+template const UtilityBinArrayKernels<std::uint64_t> &getUtilityBinArrayKernels(const std::string &isa);
+
+}// namespace dphim